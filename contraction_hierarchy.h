@@ -0,0 +1,441 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "search_space.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace ptb { class Protobuffer; }
+
+namespace graph {
+
+template <typename Weight>
+class ContractionHierarchyRouter {
+private:
+    friend ptb::Protobuffer;
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+
+    // Дуга иерархии: ребро исходного графа (id < edge_count) или шорткат (id - edge_count)
+    struct Arc {
+        VertexId to;
+        Weight weight;
+        EdgeId id;
+    };
+
+    struct Shortcut {
+        EdgeId first;
+        EdgeId second;
+    };
+
+    // Дуги, ведущие вверх по иерархии: прямые для поиска от начала маршрута
+    // и обращённые для поиска от конца, в формате CSR
+    struct Overlay {
+        size_t edge_count = 0;
+        std::vector<size_t> up_offsets;
+        std::vector<Arc> up_arcs;
+        std::vector<size_t> down_offsets;
+        std::vector<Arc> down_arcs;
+        std::vector<Shortcut> shortcuts;
+    };
+
+    explicit ContractionHierarchyRouter(const Graph& graph);
+    ContractionHierarchyRouter(const Graph& graph, Overlay overlay);
+
+    using Space = SearchSpace<Weight>;
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // поиск в рабочих массивах вызывающего, рёбра пути пишутся в его буфер
+    std::optional<Weight> BuildRoute(VertexId from, VertexId to, Space& forward, Space& backward,
+                                     std::vector<EdgeId>& edges) const;
+
+private:
+    class Contractor;
+
+    void UnpackArc(EdgeId arc_id, std::vector<EdgeId>& stack, std::vector<EdgeId>& edges) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight NO_ROUTE = std::numeric_limits<Weight>::infinity();
+    const Graph& graph_;
+    Overlay overlay_;
+};
+
+// Последовательно стягивает вершины в порядке возрастания приоритета (разность рёбер
+// плюс число стянутых соседей) и добавляет шорткаты там, где поиск свидетеля
+// не нашёл обходного пути не длиннее пути через стягиваемую вершину
+template <typename Weight>
+class ContractionHierarchyRouter<Weight>::Contractor {
+public:
+    explicit Contractor(const Graph& graph)
+        : edge_count_(graph.GetEdgeCount())
+        , out_(graph.GetVertexCount())
+        , in_(graph.GetVertexCount())
+        , contracted_(graph.GetVertexCount(), false)
+        , contracted_neighbours_(graph.GetVertexCount(), 0)
+        , ranks_(graph.GetVertexCount(), 0)
+        , witness_weights_(graph.GetVertexCount(), NO_ROUTE)
+        , witness_targets_(graph.GetVertexCount(), false)
+    {
+        for (EdgeId edge_id = 0; edge_id < edge_count_; ++edge_id) {
+            const auto& edge = graph.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            arcs_.push_back({edge.from, edge.to, edge.weight});
+            if (edge.from != edge.to) {
+                AddOrImproveArc(edge.from, edge.to, edge.weight, edge_id);
+            }
+        }
+    }
+
+    Overlay Contract() {
+        using QueueItem = std::pair<int, VertexId>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+        const size_t vertex_count = out_.size();
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            queue.push({ComputePriority(vertex), vertex});
+        }
+
+        size_t rank = 0;
+        while (!queue.empty()) {
+            const VertexId vertex = queue.top().second;
+            queue.pop();
+            if (contracted_[vertex]) {
+                continue;
+            }
+            // ленивое обновление: приоритет мог вырасти после стягивания соседей
+            const int priority = ComputePriority(vertex);
+            if (!queue.empty() && priority > queue.top().first) {
+                queue.push({priority, vertex});
+                continue;
+            }
+            ContractVertex(vertex);
+            ranks_[vertex] = rank++;
+        }
+
+        return BuildOverlay();
+    }
+
+private:
+    struct Neighbour {
+        VertexId vertex;
+        Weight weight;
+        EdgeId id;
+    };
+
+    struct ArcEnds {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+    };
+
+    // ограничения поиска свидетелей: при оценке приоритета достаточно грубого подсчёта шорткатов,
+    // лишний шорткат при стягивании не нарушает корректность, а лишь увеличивает иерархию
+    static constexpr size_t MAX_WITNESS_SETTLED_ESTIMATE = 20;
+    static constexpr size_t MAX_WITNESS_SETTLED = 100;
+
+    void AddOrImproveArc(VertexId from, VertexId to, Weight weight, EdgeId id) {
+        for (auto& neighbour : out_[from]) {
+            if (neighbour.vertex == to) {
+                if (weight < neighbour.weight) {
+                    neighbour = {to, weight, id};
+                    for (auto& back : in_[to]) {
+                        if (back.vertex == from) {
+                            back = {from, weight, id};
+                        }
+                    }
+                }
+                return;
+            }
+        }
+        out_[from].push_back({to, weight, id});
+        in_[to].push_back({from, weight, id});
+    }
+
+    // Кратчайшие пути из source в обход вершины excluded по ещё не стянутым вершинам,
+    // поиск прекращается, когда найдены все target_count целевых вершин
+    void FindWitnesses(VertexId source, VertexId excluded, Weight limit, size_t target_count, size_t max_settled) {
+        using QueueItem = std::pair<Weight, VertexId>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+        for (const VertexId vertex : witness_touched_) {
+            witness_weights_[vertex] = NO_ROUTE;
+        }
+        witness_touched_.clear();
+
+        witness_weights_[source] = ZERO_WEIGHT;
+        witness_touched_.push_back(source);
+        queue.push({ZERO_WEIGHT, source});
+        size_t settled = 0;
+        while (!queue.empty() && settled < max_settled) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (witness_weights_[vertex] < weight) {
+                continue;
+            }
+            if (limit < weight) {
+                break;
+            }
+            ++settled;
+            if (witness_targets_[vertex] && --target_count == 0) {
+                break;
+            }
+            for (const auto& neighbour : out_[vertex]) {
+                if (neighbour.vertex == excluded) {
+                    continue;
+                }
+                const Weight candidate_weight = weight + neighbour.weight;
+                if (candidate_weight < witness_weights_[neighbour.vertex]) {
+                    if (witness_weights_[neighbour.vertex] == NO_ROUTE) {
+                        witness_touched_.push_back(neighbour.vertex);
+                    }
+                    witness_weights_[neighbour.vertex] = candidate_weight;
+                    queue.push({candidate_weight, neighbour.vertex});
+                }
+            }
+        }
+    }
+
+    // Обходит пары (вход, выход) вершины, для которых нужен шорткат
+    template <typename Callback>
+    void ForEachShortcut(VertexId vertex, size_t max_settled, Callback callback) {
+        Weight max_out_weight = ZERO_WEIGHT;
+        for (const auto& out : out_[vertex]) {
+            max_out_weight = std::max(max_out_weight, out.weight);
+            witness_targets_[out.vertex] = true;
+        }
+        for (const auto& in : in_[vertex]) {
+            FindWitnesses(in.vertex, vertex, in.weight + max_out_weight, out_[vertex].size(), max_settled);
+            for (const auto& out : out_[vertex]) {
+                if (out.vertex == in.vertex) {
+                    continue;
+                }
+                const Weight via_weight = in.weight + out.weight;
+                if (witness_weights_[out.vertex] <= via_weight) {
+                    continue;
+                }
+                callback(in, out, via_weight);
+            }
+        }
+        for (const auto& out : out_[vertex]) {
+            witness_targets_[out.vertex] = false;
+        }
+    }
+
+    int ComputePriority(VertexId vertex) {
+        int shortcut_count = 0;
+        ForEachShortcut(vertex, MAX_WITNESS_SETTLED_ESTIMATE, [&shortcut_count](const Neighbour&, const Neighbour&, Weight) {
+            ++shortcut_count;
+        });
+        const int degree = static_cast<int>(out_[vertex].size() + in_[vertex].size());
+        return shortcut_count - degree + contracted_neighbours_[vertex];
+    }
+
+    void ContractVertex(VertexId vertex) {
+        std::vector<std::pair<ArcEnds, Shortcut>> shortcuts;
+        ForEachShortcut(vertex, MAX_WITNESS_SETTLED, [&shortcuts](const Neighbour& in, const Neighbour& out, Weight weight) {
+            shortcuts.push_back({{in.vertex, out.vertex, weight}, {in.id, out.id}});
+        });
+        for (const auto& [ends, shortcut] : shortcuts) {
+            const EdgeId id = arcs_.size();
+            arcs_.push_back(ends);
+            shortcuts_.push_back(shortcut);
+            AddOrImproveArc(ends.from, ends.to, ends.weight, id);
+        }
+
+        // стянутая вершина больше не участвует в поиске свидетелей, убираем её из списков соседей
+        contracted_[vertex] = true;
+        auto is_vertex = [vertex](const Neighbour& neighbour) {
+            return neighbour.vertex == vertex;
+        };
+        for (const auto& out : out_[vertex]) {
+            ++contracted_neighbours_[out.vertex];
+            auto& list = in_[out.vertex];
+            list.erase(std::remove_if(list.begin(), list.end(), is_vertex), list.end());
+        }
+        for (const auto& in : in_[vertex]) {
+            ++contracted_neighbours_[in.vertex];
+            auto& list = out_[in.vertex];
+            list.erase(std::remove_if(list.begin(), list.end(), is_vertex), list.end());
+        }
+        out_[vertex].clear();
+        in_[vertex].clear();
+    }
+
+    Overlay BuildOverlay() {
+        const size_t vertex_count = out_.size();
+        Overlay overlay;
+        overlay.edge_count = edge_count_;
+        overlay.shortcuts = std::move(shortcuts_);
+
+        std::vector<std::vector<Arc>> up(vertex_count);
+        std::vector<std::vector<Arc>> down(vertex_count);
+        for (EdgeId id = 0; id < arcs_.size(); ++id) {
+            const auto& arc = arcs_[id];
+            if (arc.from == arc.to) {
+                continue;
+            }
+            if (ranks_[arc.from] < ranks_[arc.to]) {
+                up[arc.from].push_back({arc.to, arc.weight, id});
+            }
+            else {
+                down[arc.to].push_back({arc.from, arc.weight, id});
+            }
+        }
+
+        auto flatten = [vertex_count](std::vector<std::vector<Arc>>& lists,
+                                      std::vector<size_t>& offsets, std::vector<Arc>& arcs) {
+            offsets.reserve(vertex_count + 1);
+            offsets.push_back(0);
+            for (auto& list : lists) {
+                arcs.insert(arcs.end(), list.begin(), list.end());
+                offsets.push_back(arcs.size());
+            }
+        };
+        flatten(up, overlay.up_offsets, overlay.up_arcs);
+        flatten(down, overlay.down_offsets, overlay.down_arcs);
+        return overlay;
+    }
+
+    const size_t edge_count_;
+    std::vector<std::vector<Neighbour>> out_;
+    std::vector<std::vector<Neighbour>> in_;
+    std::vector<bool> contracted_;
+    std::vector<int> contracted_neighbours_;
+    std::vector<size_t> ranks_;
+    std::vector<ArcEnds> arcs_;
+    std::vector<Shortcut> shortcuts_;
+    std::vector<Weight> witness_weights_;
+    std::vector<VertexId> witness_touched_;
+    std::vector<bool> witness_targets_;
+};
+
+template <typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph)
+    : graph_(graph)
+    , overlay_(Contractor(graph).Contract())
+{
+}
+
+template <typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph, Overlay overlay)
+    : graph_(graph)
+    , overlay_(std::move(overlay))
+{
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchyRouter<Weight>::RouteInfo>
+ContractionHierarchyRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    Space forward;
+    Space backward;
+    std::vector<EdgeId> edges;
+    if (const auto weight = BuildRoute(from, to, forward, backward, edges)) {
+        return RouteInfo{*weight, std::move(edges)};
+    }
+    return std::nullopt;
+}
+
+template <typename Weight>
+std::optional<Weight> ContractionHierarchyRouter<Weight>::BuildRoute(VertexId from, VertexId to,
+                                                                     Space& forward, Space& backward,
+                                                                     std::vector<EdgeId>& edges) const {
+    const size_t vertex_count = overlay_.up_offsets.empty() ? 0 : overlay_.up_offsets.size() - 1;
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    forward.Reset(vertex_count);
+    backward.Reset(vertex_count);
+    forward.SetWeight(from, ZERO_WEIGHT);
+    forward.Push({ZERO_WEIGHT, ZERO_WEIGHT, from});
+    backward.SetWeight(to, ZERO_WEIGHT);
+    backward.Push({ZERO_WEIGHT, ZERO_WEIGHT, to});
+
+    Weight best_weight = NO_ROUTE;
+    VertexId meeting_vertex = from;
+    // дуги вверх по иерархии: прямые для поиска от начала, обращённые для поиска от конца
+    auto step = [&best_weight, &meeting_vertex](Space& search, const std::vector<size_t>& offsets,
+                                                const std::vector<Arc>& arcs, const Space& opposite) {
+        const auto [_, weight, vertex] = search.Pop();
+        if (search.weights[vertex] < weight) {
+            return;
+        }
+        if (weight + opposite.weights[vertex] < best_weight) {
+            best_weight = weight + opposite.weights[vertex];
+            meeting_vertex = vertex;
+        }
+        for (size_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+            const Arc& arc = arcs[i];
+            const Weight candidate_weight = weight + arc.weight;
+            if (candidate_weight < search.weights[arc.to]) {
+                search.SetWeight(arc.to, candidate_weight);
+                search.prev_vertices[arc.to] = vertex;
+                search.prev_edges[arc.to] = arc.id;
+                search.Push({candidate_weight, candidate_weight, arc.to});
+            }
+        }
+    };
+    // каждая сторона останавливается, когда её минимальный ключ не меньше лучшего найденного пути
+    while (true) {
+        const bool forward_active = !forward.queue.empty() && std::get<0>(forward.Top()) < best_weight;
+        const bool backward_active = !backward.queue.empty() && std::get<0>(backward.Top()) < best_weight;
+        if (!forward_active && !backward_active) {
+            break;
+        }
+        if (forward_active) {
+            step(forward, overlay_.up_offsets, overlay_.up_arcs, backward);
+        }
+        if (backward_active) {
+            step(backward, overlay_.down_offsets, overlay_.down_arcs, forward);
+        }
+    }
+
+    edges.clear();
+    if (best_weight == NO_ROUTE) {
+        return std::nullopt;
+    }
+
+    auto& arcs = forward.arcs;
+    arcs.clear();
+    for (VertexId vertex = meeting_vertex; vertex != from; vertex = forward.prev_vertices[vertex]) {
+        arcs.push_back(forward.prev_edges[vertex]);
+    }
+    std::reverse(arcs.begin(), arcs.end());
+    for (VertexId vertex = meeting_vertex; vertex != to; vertex = backward.prev_vertices[vertex]) {
+        arcs.push_back(backward.prev_edges[vertex]);
+    }
+
+    for (const EdgeId arc_id : arcs) {
+        UnpackArc(arc_id, backward.arcs, edges);
+    }
+    return best_weight;
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::UnpackArc(EdgeId arc_id, std::vector<EdgeId>& stack,
+                                                   std::vector<EdgeId>& edges) const {
+    stack.assign(1, arc_id);
+    while (!stack.empty()) {
+        const EdgeId id = stack.back();
+        stack.pop_back();
+        if (id < overlay_.edge_count) {
+            edges.push_back(id);
+            continue;
+        }
+        const Shortcut& shortcut = overlay_.shortcuts[id - overlay_.edge_count];
+        stack.push_back(shortcut.second);
+        stack.push_back(shortcut.first);
+    }
+}
+
+}  // namespace graph
@@ -0,0 +1,438 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "search_space.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+template <typename Weight>
+class DijkstraRouter {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+    using Space = SearchSpace<Weight>;
+
+    explicit DijkstraRouter(const Graph& graph);
+
+    // Поиски с параметром space работают в рабочих массивах вызывающего и пишут рёбра пути
+    // в его буфер; без него массивы заводятся на каждый поиск
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    std::optional<Weight> BuildRoute(VertexId from, VertexId to, Space& space, std::vector<EdgeId>& edges) const;
+
+    // Поиск A*: heuristic(vertex) - нижняя оценка веса пути от vertex до to
+    template <typename Heuristic>
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, Heuristic heuristic) const;
+    template <typename Heuristic>
+    std::optional<Weight> BuildRoute(VertexId from, VertexId to, Heuristic heuristic,
+                                     Space& space, std::vector<EdgeId>& edges) const;
+
+    // Двунаправленный поиск: от from по исходящим рёбрам и от to по входящим
+    std::optional<RouteInfo> BuildRouteBidirectional(VertexId from, VertexId to) const;
+    std::optional<Weight> BuildRouteBidirectional(VertexId from, VertexId to, Space& forward, Space& backward,
+                                                  std::vector<EdgeId>& edges) const;
+
+    // Дерево кратчайших путей из одной вершины: веса путей и последние рёбра путей по вершинам
+    using RoutesTree = Space;
+
+    // Поиск останавливается, когда пройдены все вершины targets; пустой список - строится всё дерево
+    RoutesTree BuildRoutesTree(VertexId from, const std::vector<VertexId>& targets = {}) const;
+    void BuildRoutesTree(VertexId from, const std::vector<VertexId>& targets, RoutesTree& tree) const;
+    std::optional<RouteInfo> BuildRoute(const RoutesTree& tree, VertexId to) const;
+    // рёбра пути записываются в буфер вызывающего
+    std::optional<Weight> BuildRoute(const RoutesTree& tree, VertexId to, std::vector<EdgeId>& edges) const;
+
+    // Вершины, до которых есть путь весом не больше max_weight, с весами путей в порядке их возрастания.
+    // Вершины за границей в очередь не попадают, поэтому поиск не выходит за неё
+    std::vector<std::pair<VertexId, Weight>> GetReachableVertices(VertexId from, Weight max_weight) const;
+
+    // путь и сумма счётчиков его рёбер
+    struct CountedRoute {
+        RouteInfo route;
+        size_t count;
+    };
+
+    // Пути, оптимальные по Парето по весу и по сумме целых счётчиков counter(edge_id) рёбер пути
+    // (например, числу посадок): для каждого значения суммы - самый лёгкий путь, если он легче всех
+    // путей с меньшей суммой. Пути идут по возрастанию веса и убыванию суммы
+    template <typename Counter>
+    std::vector<CountedRoute> BuildParetoRoutes(VertexId from, VertexId to, Counter counter) const;
+
+private:
+    // оценка веса всего пути через вершину, вес пути до вершины, вершина
+    using QueueItem = std::tuple<Weight, Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+};
+
+template <typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+    : graph_(graph)
+{
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+                                                                                             VertexId to) const {
+    return BuildRoute(from, to, [](VertexId) { return ZERO_WEIGHT; });
+}
+
+template <typename Weight>
+std::optional<Weight> DijkstraRouter<Weight>::BuildRoute(VertexId from, VertexId to, Space& space,
+                                                         std::vector<EdgeId>& edges) const {
+    return BuildRoute(from, to, [](VertexId) { return ZERO_WEIGHT; }, space, edges);
+}
+
+template <typename Weight>
+template <typename Heuristic>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+                                                                                             VertexId to,
+                                                                                             Heuristic heuristic) const {
+    Space space;
+    std::vector<EdgeId> edges;
+    if (const auto weight = BuildRoute(from, to, heuristic, space, edges)) {
+        return RouteInfo{*weight, std::move(edges)};
+    }
+    return std::nullopt;
+}
+
+template <typename Weight>
+template <typename Heuristic>
+std::optional<Weight> DijkstraRouter<Weight>::BuildRoute(VertexId from, VertexId to, Heuristic heuristic,
+                                                         Space& space, std::vector<EdgeId>& edges) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    space.Reset(vertex_count);
+    // устаревшие элементы очереди отбрасываются по весу пути, а не по признаку посещения,
+    // поэтому вершина может быть раскрыта повторно, если оценка не монотонна
+    space.SetWeight(from, ZERO_WEIGHT);
+    space.Push({heuristic(from), ZERO_WEIGHT, from});
+    while (!space.queue.empty()) {
+        const auto [_, weight, vertex] = space.Pop();
+        if (space.weights[vertex] < weight) {
+            continue;
+        }
+        if (vertex == to) {
+            break;
+        }
+        for (const auto& edge : graph_.GetIncidentEdges(vertex)) {
+            const Weight candidate_weight = weight + edge.weight;
+            if (candidate_weight < space.weights[edge.to]) {
+                if (!space.IsReached(edge.to)) {
+                    space.estimates[edge.to] = heuristic(edge.to);
+                }
+                space.SetWeight(edge.to, candidate_weight);
+                space.prev_edges[edge.to] = edge.id;
+                space.Push({candidate_weight + space.estimates[edge.to], candidate_weight, edge.to});
+            }
+        }
+    }
+
+    return BuildRoute(space, to, edges);
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo>
+DijkstraRouter<Weight>::BuildRouteBidirectional(VertexId from, VertexId to) const {
+    Space forward;
+    Space backward;
+    std::vector<EdgeId> edges;
+    if (const auto weight = BuildRouteBidirectional(from, to, forward, backward, edges)) {
+        return RouteInfo{*weight, std::move(edges)};
+    }
+    return std::nullopt;
+}
+
+template <typename Weight>
+std::optional<Weight> DijkstraRouter<Weight>::BuildRouteBidirectional(VertexId from, VertexId to,
+                                                                      Space& forward, Space& backward,
+                                                                      std::vector<EdgeId>& edges) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    edges.clear();
+    if (from == to) {
+        return ZERO_WEIGHT;
+    }
+
+    // ребро, по которому вершина достигнута: для прямого поиска последнее ребро пути,
+    // для обратного - первое ребро оставшейся части пути
+    forward.Reset(vertex_count);
+    backward.Reset(vertex_count);
+    forward.SetWeight(from, ZERO_WEIGHT);
+    forward.Push({ZERO_WEIGHT, ZERO_WEIGHT, from});
+    backward.SetWeight(to, ZERO_WEIGHT);
+    backward.Push({ZERO_WEIGHT, ZERO_WEIGHT, to});
+
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+    auto step = [this, &best_weight, &meeting_vertex](Space& search, bool is_forward, const Space& opposite) {
+        const auto [_, weight, vertex] = search.Pop();
+        if (search.weights[vertex] < weight) {
+            return;
+        }
+        const auto edges = is_forward ? graph_.GetIncidentEdges(vertex) : graph_.GetIncomingEdges(vertex);
+        for (const auto& edge : edges) {
+            const VertexId next = edge.to;
+            const Weight candidate_weight = weight + edge.weight;
+            if (!(candidate_weight < search.weights[next])) {
+                continue;
+            }
+            search.SetWeight(next, candidate_weight);
+            search.prev_edges[next] = edge.id;
+            search.Push({candidate_weight, candidate_weight, next});
+            if (opposite.IsReached(next)) {
+                const Weight opposite_weight = opposite.weights[next];
+                if (!best_weight || candidate_weight + opposite_weight < *best_weight) {
+                    best_weight = candidate_weight + opposite_weight;
+                    meeting_vertex = next;
+                }
+            }
+        }
+    };
+    // поиск останавливается, когда сумма минимальных ключей обеих очередей не меньше лучшего пути
+    while (!forward.queue.empty() && !backward.queue.empty()) {
+        if (best_weight && !(std::get<1>(forward.Top()) + std::get<1>(backward.Top()) < *best_weight)) {
+            break;
+        }
+        if (std::get<1>(forward.Top()) < std::get<1>(backward.Top())) {
+            step(forward, true, backward);
+        }
+        else {
+            step(backward, false, forward);
+        }
+    }
+
+    if (!best_weight) {
+        return std::nullopt;
+    }
+    for (EdgeId edge_id = forward.prev_edges[meeting_vertex];
+         edge_id != Space::NO_EDGE;
+         edge_id = forward.prev_edges[graph_.GetEdge(edge_id).from])
+    {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+    for (EdgeId edge_id = backward.prev_edges[meeting_vertex];
+         edge_id != Space::NO_EDGE;
+         edge_id = backward.prev_edges[graph_.GetEdge(edge_id).to])
+    {
+        edges.push_back(edge_id);
+    }
+
+    return *best_weight;
+}
+
+template <typename Weight>
+typename DijkstraRouter<Weight>::RoutesTree DijkstraRouter<Weight>::BuildRoutesTree(
+    VertexId from, const std::vector<VertexId>& targets) const {
+    RoutesTree tree;
+    BuildRoutesTree(from, targets, tree);
+    return tree;
+}
+
+template <typename Weight>
+void DijkstraRouter<Weight>::BuildRoutesTree(VertexId from, const std::vector<VertexId>& targets,
+                                             RoutesTree& tree) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    for (const VertexId target : targets) {
+        if (target >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+    }
+
+    tree.Reset(vertex_count);
+    auto& is_target = tree.is_target;
+    size_t targets_left = 0;
+    for (const VertexId target : targets) {
+        if (!is_target[target]) {
+            is_target[target] = true;
+            ++targets_left;
+        }
+    }
+
+    tree.SetWeight(from, ZERO_WEIGHT);
+    tree.Push({ZERO_WEIGHT, ZERO_WEIGHT, from});
+    while (!tree.queue.empty()) {
+        const auto [_, weight, vertex] = tree.Pop();
+        if (tree.weights[vertex] < weight) {
+            continue;
+        }
+        if (is_target[vertex]) {
+            is_target[vertex] = false;
+            if (--targets_left == 0) {
+                break;
+            }
+        }
+        for (const auto& edge : graph_.GetIncidentEdges(vertex)) {
+            const Weight candidate_weight = weight + edge.weight;
+            if (candidate_weight < tree.weights[edge.to]) {
+                tree.SetWeight(edge.to, candidate_weight);
+                tree.prev_edges[edge.to] = edge.id;
+                tree.Push({candidate_weight, candidate_weight, edge.to});
+            }
+        }
+    }
+    // недостигнутые цели не должны остаться отмеченными для следующего поиска
+    for (const VertexId target : targets) {
+        is_target[target] = false;
+    }
+}
+
+template <typename Weight>
+std::vector<std::pair<VertexId, Weight>> DijkstraRouter<Weight>::GetReachableVertices(VertexId from,
+                                                                                      Weight max_weight) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    std::vector<std::pair<VertexId, Weight>> reachable;
+    if (max_weight < ZERO_WEIGHT) {
+        return reachable;
+    }
+    std::vector<std::optional<Weight>> weights(vertex_count);
+    Queue queue;
+    weights[from] = ZERO_WEIGHT;
+    queue.push({ZERO_WEIGHT, ZERO_WEIGHT, from});
+    while (!queue.empty()) {
+        const auto [_, weight, vertex] = queue.top();
+        queue.pop();
+        if (*weights[vertex] < weight) {
+            continue;
+        }
+        reachable.push_back({vertex, weight});
+        for (const auto& edge : graph_.GetIncidentEdges(vertex)) {
+            const Weight candidate_weight = weight + edge.weight;
+            if (max_weight < candidate_weight) {
+                continue;
+            }
+            auto& weight_to = weights[edge.to];
+            if (!weight_to || candidate_weight < *weight_to) {
+                weight_to = candidate_weight;
+                queue.push({candidate_weight, candidate_weight, edge.to});
+            }
+        }
+    }
+
+    return reachable;
+}
+
+// Поиск с метками: у вершины может быть несколько меток (вес, сумма счётчиков). Метки извлекаются
+// по возрастанию веса, поэтому метка отбрасывается, если у вершины или у цели уже пройдена метка
+// с не большей суммой. Суммы пройденных меток вершины убывают, поэтому их не больше,
+// чем сумма на самом лёгком пути до неё, плюс одна
+template <typename Weight>
+template <typename Counter>
+std::vector<typename DijkstraRouter<Weight>::CountedRoute>
+DijkstraRouter<Weight>::BuildParetoRoutes(VertexId from, VertexId to, Counter counter) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    static constexpr size_t NO_COUNT = std::numeric_limits<size_t>::max();
+    struct Label {
+        VertexId vertex;
+        size_t prev_label;
+        EdgeId edge;
+    };
+    // вес пути, сумма счётчиков, номер метки
+    using LabelItem = std::tuple<Weight, size_t, size_t>;
+
+    std::vector<Label> labels{{from, NO_COUNT, 0}};
+    // наименьшая сумма счётчиков среди пройденных меток вершины
+    std::vector<size_t> min_counts(vertex_count, NO_COUNT);
+    std::priority_queue<LabelItem, std::vector<LabelItem>, std::greater<LabelItem>> queue;
+    queue.push({ZERO_WEIGHT, 0, 0});
+
+    std::vector<CountedRoute> routes;
+    while (!queue.empty()) {
+        const auto [weight, count, label_id] = queue.top();
+        queue.pop();
+        const VertexId vertex = labels[label_id].vertex;
+        if (count >= min_counts[vertex]) {
+            continue;
+        }
+        min_counts[vertex] = count;
+        if (vertex == to) {
+            std::vector<EdgeId> edges;
+            for (size_t id = label_id; labels[id].prev_label != NO_COUNT; id = labels[id].prev_label) {
+                edges.push_back(labels[id].edge);
+            }
+            std::reverse(edges.begin(), edges.end());
+            routes.push_back({RouteInfo{weight, std::move(edges)}, count});
+            if (count == 0) {
+                break;
+            }
+            continue;
+        }
+        for (const auto& edge : graph_.GetIncidentEdges(vertex)) {
+            const size_t next_count = count + counter(edge.id);
+            if (next_count >= min_counts[edge.to] || next_count >= min_counts[to]) {
+                continue;
+            }
+            labels.push_back({edge.to, label_id, edge.id});
+            queue.push({weight + edge.weight, next_count, labels.size() - 1});
+        }
+    }
+
+    return routes;
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(const RoutesTree& tree,
+                                                                                             VertexId to) const {
+    std::vector<EdgeId> edges;
+    if (const auto weight = BuildRoute(tree, to, edges)) {
+        return RouteInfo{*weight, std::move(edges)};
+    }
+    return std::nullopt;
+}
+
+template <typename Weight>
+std::optional<Weight> DijkstraRouter<Weight>::BuildRoute(const RoutesTree& tree, VertexId to,
+                                                         std::vector<EdgeId>& edges) const {
+    edges.clear();
+    if (!tree.IsReached(to)) {
+        return std::nullopt;
+    }
+    for (EdgeId edge_id = tree.prev_edges[to];
+         edge_id != RoutesTree::NO_EDGE;
+         edge_id = tree.prev_edges[graph_.GetEdge(edge_id).from])
+    {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return tree.weights[to];
+}
+
+}  // namespace graph
@@ -13,6 +13,7 @@
 #include "geo.h"
 #include "svg.h"
 
+#include <cstdint>
 #include <vector>
 #include <memory>
 #include <string>
@@ -33,16 +34,22 @@ struct RouteStats {
 	size_t unique_stop_count = 0;
 };
 
+// Номера остановок и автобусов - позиции в массивах справочника в порядке добавления,
+// имена нужны только для поиска по запросу и для вывода ответа
+using StopId = uint32_t;
+using BusId = uint32_t;
+
 struct Stop {
 	std::string name;
 	geo::Coordinates coord;
-	std::unordered_map<std::string, int> road_distances;
+	StopId id = 0;
 };
 
 struct Bus {
 	std::string name;
-	std::vector<const Stop*> route;
+	std::vector<StopId> route;
 	bool is_roundtrip = false;
+	BusId id = 0;
 };
 
 using BusPtr = const Bus*;
@@ -52,6 +59,11 @@ enum class enStatRequestsType {
 	BUS,
 	MAP,
 	ROUTE,
+	ISOCHRONE,
+	MATRIX,
+	NEAREST_STOPS,
+	STOPS_WITHIN,
+	STOP_SEARCH,
 	SERIALIZE,
 };
 
@@ -61,8 +73,32 @@ struct StatRequest {
 	std::string name;
 	std::string from;
 	std::string to;
+	// для запроса Route: самые быстрые маршруты для каждого числа пересадок
+	bool pareto = false;
+	// время в пути в минутах для запроса Isochrone
+	double max_time = 0.0;
+	// остановки отправления и назначения для запроса Matrix
+	std::vector<std::string> from_stops;
+	std::vector<std::string> to_stops;
+	// точка, число остановок и радиус в метрах для запросов NearestStops и StopsWithin
+	geo::Coordinates coord{};
+	size_t count = 0;
+	double radius = 0.0;
+	// допустимое число опечаток в запросе StopSearch; начало имени - в name, число ответов - в count
+	size_t max_edits = 0;
 };
 
-using StopBuses = const std::set<BusPtr>*;
+// имена автобусов, проходящих через остановку, по алфавиту
+using StopBuses = std::vector<std::string_view>;
+
+// остановка рядом с точкой и расстояние до неё в метрах
+struct NearbyStop {
+	const Stop* stop = nullptr;
+	double distance = 0.0;
+};
 
-using AllBusesPtr = const std::unordered_map<std::string_view, BusPtr>*;
\ No newline at end of file
+// остановка, найденная по началу имени, и число правок в запросе
+struct StopMatch {
+	const Stop* stop = nullptr;
+	size_t edits = 0;
+};
\ No newline at end of file
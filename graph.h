@@ -3,6 +3,7 @@
 #include "ranges.h"
 
 #include <cstdlib>
+#include <stdexcept>
 #include <vector>
 
 namespace ptb { class Protobuffer; }
@@ -19,44 +20,116 @@ struct Edge {
     Weight weight;
 };
 
+// Запись списка смежности: соседняя вершина в направлении обхода (для входящих рёбер -
+// начало ребра), вес и номер ребра
+template <typename Weight>
+struct IncidentEdge {
+    VertexId to;
+    Weight weight;
+    EdgeId id;
+};
+
+// Рёбра добавляются в изменяемый граф, после чего Freeze строит списки смежности
+// в формате CSR: смещения по вершинам и непрерывный массив записей
 template <typename Weight>
 class DirectedWeightedGraph {
 private:
     friend ptb::Protobuffer;
-    using IncidenceList = std::vector<EdgeId>;
+    using IncidenceList = std::vector<IncidentEdge<Weight>>;
     using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
 
 public:
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
+    VertexId AddVertex();
     EdgeId AddEdge(const Edge<Weight>& edge);
+    void Freeze();
+    // возвращает граф в изменяемое состояние для добавления вершин и рёбер
+    void Unfreeze();
 
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
     const Edge<Weight>& GetEdge(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+    IncidentEdgesRange GetIncomingEdges(VertexId vertex) const;
 
 private:
+    struct CompressedLists {
+        std::vector<size_t> offsets;
+        IncidenceList records;
+    };
+
+    IncidentEdgesRange GetRange(const CompressedLists& lists, VertexId vertex) const;
+
+    size_t vertex_count_ = 0;
+    bool frozen_ = false;
     std::vector<Edge<Weight>> edges_;
-    std::vector<IncidenceList> incidence_lists_;
+    CompressedLists outgoing_;
+    CompressedLists incoming_;
 };
 
 template <typename Weight>
 DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-    : incidence_lists_(vertex_count) {
+    : vertex_count_(vertex_count) {
+}
+
+template <typename Weight>
+VertexId DirectedWeightedGraph<Weight>::AddVertex() {
+    if (frozen_) {
+        throw std::logic_error("Graph is frozen");
+    }
+    return vertex_count_++;
 }
 
 template <typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
+    if (frozen_) {
+        throw std::logic_error("Graph is frozen");
+    }
+    if (edge.from >= vertex_count_ || edge.to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
     edges_.push_back(edge);
-    const EdgeId id = edges_.size() - 1;
-    incidence_lists_.at(edge.from).push_back(id);
-    return id;
+    return edges_.size() - 1;
+}
+
+// Записи раскладываются сортировкой подсчётом, поэтому рёбра каждой вершины
+// идут в порядке добавления
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::Freeze() {
+    outgoing_.offsets.assign(vertex_count_ + 1, 0);
+    incoming_.offsets.assign(vertex_count_ + 1, 0);
+    for (const auto& edge : edges_) {
+        ++outgoing_.offsets[edge.from + 1];
+        ++incoming_.offsets[edge.to + 1];
+    }
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        outgoing_.offsets[vertex + 1] += outgoing_.offsets[vertex];
+        incoming_.offsets[vertex + 1] += incoming_.offsets[vertex];
+    }
+
+    outgoing_.records.resize(edges_.size());
+    incoming_.records.resize(edges_.size());
+    std::vector<size_t> outgoing_pos(outgoing_.offsets.begin(), outgoing_.offsets.end() - 1);
+    std::vector<size_t> incoming_pos(incoming_.offsets.begin(), incoming_.offsets.end() - 1);
+    for (EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+        const auto& edge = edges_[edge_id];
+        outgoing_.records[outgoing_pos[edge.from]++] = {edge.to, edge.weight, edge_id};
+        incoming_.records[incoming_pos[edge.to]++] = {edge.from, edge.weight, edge_id};
+    }
+    frozen_ = true;
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::Unfreeze() {
+    outgoing_ = {};
+    incoming_ = {};
+    frozen_ = false;
 }
 
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-    return incidence_lists_.size();
+    return vertex_count_;
 }
 
 template <typename Weight>
@@ -69,10 +142,28 @@ const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const
     return edges_.at(edge_id);
 }
 
+template <typename Weight>
+typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
+DirectedWeightedGraph<Weight>::GetRange(const CompressedLists& lists, VertexId vertex) const {
+    if (!frozen_) {
+        throw std::logic_error("Graph should be frozen before traversal");
+    }
+    if (vertex >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    return {lists.records.begin() + lists.offsets[vertex], lists.records.begin() + lists.offsets[vertex + 1]};
+}
+
 template <typename Weight>
 typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-    return ranges::AsRange(incidence_lists_.at(vertex));
+    return GetRange(outgoing_, vertex);
+}
+
+template <typename Weight>
+typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
+DirectedWeightedGraph<Weight>::GetIncomingEdges(VertexId vertex) const {
+    return GetRange(incoming_, vertex);
 }
 
 }  // namespace graph
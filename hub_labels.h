@@ -0,0 +1,335 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace ptb { class Protobuffer; }
+
+namespace graph {
+
+// Индекс 2-hop покрытия: у каждой вершины есть метки с весами путей до хабов и от хабов,
+// вес маршрута - минимум суммы по общим хабам двух меток
+template <typename Weight>
+class HubLabelRouter {
+private:
+    friend ptb::Protobuffer;
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+    // Метки всех вершин в формате CSR. Хабы - номера вершин в порядке построения,
+    // в каждой метке отсортированы по возрастанию. Ребро - первое (для путей к хабу)
+    // или последнее (для путей от хаба) ребро пути, NO_EDGE - вершина сама является хабом
+    struct Labels {
+        std::vector<size_t> offsets;
+        std::vector<uint32_t> hubs;
+        std::vector<Weight> weights;
+        std::vector<EdgeId> edges;
+    };
+
+    struct Index {
+        Labels out_labels;  // пути от вершины к хабам
+        Labels in_labels;   // пути от хабов к вершине
+    };
+
+    explicit HubLabelRouter(const Graph& graph);
+    HubLabelRouter(const Graph& graph, Index index);
+
+    std::optional<Weight> GetRouteWeight(VertexId from, VertexId to) const;
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    std::optional<Weight> BuildRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const;
+
+private:
+    class Builder;
+
+    // лучший общий хаб: вес пути и позиции хаба в метках начала и конца
+    struct Meeting {
+        Weight weight;
+        size_t out_pos;
+        size_t in_pos;
+    };
+
+    std::optional<Meeting> FindMeeting(VertexId from, VertexId to) const;
+    // позиция хаба в метке вершины
+    size_t FindHub(const Labels& labels, VertexId vertex, uint32_t hub) const;
+    void CheckVertex(VertexId vertex) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight NO_ROUTE = std::numeric_limits<Weight>::infinity();
+    const Graph& graph_;
+    Index index_;
+};
+
+// Метки строятся поиском Дейкстры с отсечением из каждой вершины по убыванию степени:
+// вершина не получает хаб, если путь до неё уже покрыт метками более важных хабов
+template <typename Weight>
+class HubLabelRouter<Weight>::Builder {
+public:
+    explicit Builder(const Graph& graph)
+        : graph_(graph)
+        , out_(graph.GetVertexCount())
+        , in_(graph.GetVertexCount())
+        , hub_weights_(graph.GetVertexCount(), NO_ROUTE)
+        , weights_(graph.GetVertexCount(), NO_ROUTE)
+        , edges_(graph.GetVertexCount(), NO_EDGE)
+    {
+        if (graph.GetVertexCount() > std::numeric_limits<uint32_t>::max()) {
+            throw std::length_error("Too many vertices for hub labels");
+        }
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+    }
+
+    Index Build() {
+        const size_t vertex_count = graph_.GetVertexCount();
+        std::vector<std::pair<size_t, VertexId>> order;
+        order.reserve(vertex_count);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            const auto outgoing = graph_.GetIncidentEdges(vertex);
+            const auto incoming = graph_.GetIncomingEdges(vertex);
+            const size_t out_degree = outgoing.end() - outgoing.begin();
+            const size_t in_degree = incoming.end() - incoming.begin();
+            order.push_back({(out_degree + 1) * (in_degree + 1), vertex});
+        }
+        std::stable_sort(order.begin(), order.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first > rhs.first;
+        });
+
+        for (uint32_t hub = 0; hub < vertex_count; ++hub) {
+            PrunedSearch(order[hub].second, hub, true);
+            PrunedSearch(order[hub].second, hub, false);
+        }
+        return {Flatten(out_), Flatten(in_)};
+    }
+
+private:
+    struct Entry {
+        uint32_t hub;
+        Weight weight;
+        EdgeId edge;
+    };
+    using Label = std::vector<Entry>;
+
+    // прямой поиск добавляет хаб в метки путей от хаба, обратный - в метки путей к хабу
+    void PrunedSearch(VertexId root, uint32_t hub, bool is_forward) {
+        const Label& root_label = is_forward ? out_[root] : in_[root];
+        std::vector<Label>& labels = is_forward ? in_ : out_;
+        for (const Entry& entry : root_label) {
+            hub_weights_[entry.hub] = entry.weight;
+        }
+
+        using QueueItem = std::pair<Weight, VertexId>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+        std::vector<VertexId> touched{root};
+        weights_[root] = ZERO_WEIGHT;
+        queue.push({ZERO_WEIGHT, root});
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (weights_[vertex] < weight || IsCovered(labels[vertex], weight)) {
+                continue;
+            }
+            labels[vertex].push_back({hub, weight, edges_[vertex]});
+
+            const auto edges = is_forward ? graph_.GetIncidentEdges(vertex) : graph_.GetIncomingEdges(vertex);
+            for (const auto& edge : edges) {
+                const VertexId next = edge.to;
+                const Weight candidate_weight = weight + edge.weight;
+                if (candidate_weight < weights_[next]) {
+                    if (weights_[next] == NO_ROUTE) {
+                        touched.push_back(next);
+                    }
+                    weights_[next] = candidate_weight;
+                    edges_[next] = edge.id;
+                    queue.push({candidate_weight, next});
+                }
+            }
+        }
+
+        for (const VertexId vertex : touched) {
+            weights_[vertex] = NO_ROUTE;
+            edges_[vertex] = NO_EDGE;
+        }
+        for (const Entry& entry : root_label) {
+            hub_weights_[entry.hub] = NO_ROUTE;
+        }
+    }
+
+    bool IsCovered(const Label& label, Weight weight) const {
+        for (const Entry& entry : label) {
+            if (hub_weights_[entry.hub] != NO_ROUTE && !(weight < hub_weights_[entry.hub] + entry.weight)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static Labels Flatten(const std::vector<Label>& labels) {
+        Labels result;
+        result.offsets.reserve(labels.size() + 1);
+        result.offsets.push_back(0);
+        for (const Label& label : labels) {
+            for (const Entry& entry : label) {
+                result.hubs.push_back(entry.hub);
+                result.weights.push_back(entry.weight);
+                result.edges.push_back(entry.edge);
+            }
+            result.offsets.push_back(result.hubs.size());
+        }
+        return result;
+    }
+
+    const Graph& graph_;
+    std::vector<Label> out_;
+    std::vector<Label> in_;
+    // веса меток корня поиска по номеру хаба
+    std::vector<Weight> hub_weights_;
+    std::vector<Weight> weights_;
+    std::vector<EdgeId> edges_;
+};
+
+template <typename Weight>
+HubLabelRouter<Weight>::HubLabelRouter(const Graph& graph)
+    : graph_(graph)
+    , index_(Builder(graph).Build())
+{
+}
+
+template <typename Weight>
+HubLabelRouter<Weight>::HubLabelRouter(const Graph& graph, Index index)
+    : graph_(graph)
+    , index_(std::move(index))
+{
+}
+
+template <typename Weight>
+void HubLabelRouter<Weight>::CheckVertex(VertexId vertex) const {
+    if (vertex + 1 >= index_.out_labels.offsets.size()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+}
+
+template <typename Weight>
+std::optional<typename HubLabelRouter<Weight>::Meeting> HubLabelRouter<Weight>::FindMeeting(VertexId from,
+                                                                                            VertexId to) const {
+    const Labels& out = index_.out_labels;
+    const Labels& in = index_.in_labels;
+    std::optional<Meeting> best;
+    size_t out_pos = out.offsets[from];
+    size_t in_pos = in.offsets[to];
+    while (out_pos < out.offsets[from + 1] && in_pos < in.offsets[to + 1]) {
+        if (out.hubs[out_pos] < in.hubs[in_pos]) {
+            ++out_pos;
+        }
+        else if (in.hubs[in_pos] < out.hubs[out_pos]) {
+            ++in_pos;
+        }
+        else {
+            const Weight weight = out.weights[out_pos] + in.weights[in_pos];
+            if (!best || weight < best->weight) {
+                best = Meeting{weight, out_pos, in_pos};
+            }
+            ++out_pos;
+            ++in_pos;
+        }
+    }
+    return best;
+}
+
+template <typename Weight>
+std::optional<Weight> HubLabelRouter<Weight>::GetRouteWeight(VertexId from, VertexId to) const {
+    CheckVertex(from);
+    CheckVertex(to);
+    if (const auto meeting = FindMeeting(from, to)) {
+        return meeting->weight;
+    }
+    return std::nullopt;
+}
+
+template <typename Weight>
+std::optional<typename HubLabelRouter<Weight>::RouteInfo> HubLabelRouter<Weight>::BuildRoute(VertexId from,
+                                                                                             VertexId to) const {
+    std::vector<EdgeId> edges;
+    if (const auto weight = BuildRoute(from, to, edges)) {
+        return RouteInfo{*weight, std::move(edges)};
+    }
+    return std::nullopt;
+}
+
+// Путь восстанавливается по рёбрам меток лучшего хаба: ребро метки ведёт к родителю
+// в дереве поиска из хаба, а у родителя в метке тот же хаб. Поэтому каждый шаг
+// приближается к хабу, и рёбра нулевого веса не зацикливают разбор. Части пути до хаба
+// и от хаба простые, но могут пересечься на цикле нулевого веса - он вырезается
+template <typename Weight>
+std::optional<Weight> HubLabelRouter<Weight>::BuildRoute(VertexId from, VertexId to,
+                                                         std::vector<EdgeId>& edges) const {
+    CheckVertex(from);
+    CheckVertex(to);
+    edges.clear();
+    const auto meeting = FindMeeting(from, to);
+    if (!meeting) {
+        return std::nullopt;
+    }
+    if (from == to) {
+        return meeting->weight;
+    }
+
+    const uint32_t hub = index_.out_labels.hubs[meeting->out_pos];
+    std::vector<EdgeId>& head = edges;
+    for (size_t pos = meeting->out_pos; index_.out_labels.edges[pos] != NO_EDGE;) {
+        const EdgeId edge_id = index_.out_labels.edges[pos];
+        head.push_back(edge_id);
+        pos = FindHub(index_.out_labels, graph_.GetEdge(edge_id).to, hub);
+    }
+    std::vector<EdgeId> tail;
+    // вершины пути от хаба и число рёбер tail от них до конца
+    std::vector<std::pair<VertexId, size_t>> tail_vertices{{to, 0}};
+    for (size_t pos = meeting->in_pos; index_.in_labels.edges[pos] != NO_EDGE;) {
+        const EdgeId edge_id = index_.in_labels.edges[pos];
+        tail.push_back(edge_id);
+        tail_vertices.push_back({graph_.GetEdge(edge_id).from, tail.size()});
+        pos = FindHub(index_.in_labels, graph_.GetEdge(edge_id).from, hub);
+    }
+    std::sort(tail_vertices.begin(), tail_vertices.end());
+
+    // первая вершина пути к хабу, через которую проходит и путь от хаба (хаб - всегда такая)
+    VertexId vertex = from;
+    for (size_t head_size = 0;; vertex = graph_.GetEdge(head[head_size++]).to) {
+        const auto it = std::lower_bound(tail_vertices.begin(), tail_vertices.end(),
+                                         std::pair<VertexId, size_t>{vertex, 0});
+        if (it != tail_vertices.end() && it->first == vertex) {
+            head.resize(head_size);
+            head.insert(head.end(), tail.rend() - it->second, tail.rend());
+            return meeting->weight;
+        }
+    }
+}
+
+template <typename Weight>
+size_t HubLabelRouter<Weight>::FindHub(const Labels& labels, VertexId vertex, uint32_t hub) const {
+    const auto begin = labels.hubs.begin() + labels.offsets[vertex];
+    const auto end = labels.hubs.begin() + labels.offsets[vertex + 1];
+    const auto it = std::lower_bound(begin, end, hub);
+    if (it == end || *it != hub) {
+        throw std::logic_error("Hub labels do not describe a shortest path");
+    }
+    return it - labels.hubs.begin();
+}
+
+}  // namespace graph
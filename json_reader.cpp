@@ -65,10 +65,79 @@ void JsonReader::ReadRoutingSettings(Dict json) const  {
 		else if (s.first == "bus_velocity"s) {
 			settings.bus_velocity = s.second.AsDouble();
 		}
+		else if (s.first == "router_type"s) {
+			settings.router_type = ReadRouterType(s.second.AsString());
+		}
+		else if (s.first == "build_threads"s) {
+			settings.build_threads = s.second.AsInt();
+		}
+		else if (s.first == "route_cache_size"s) {
+			settings.route_cache_size = s.second.AsInt();
+		}
+		else if (s.first == "query_threads"s) {
+			settings.query_threads = s.second.AsInt();
+		}
+		else if (s.first == "route_rows_limit"s) {
+			settings.route_rows_limit = s.second.AsInt();
+		}
+		else if (s.first == "graph_model"s) {
+			settings.graph_model = ReadGraphModel(s.second.AsString());
+		}
+		else if (s.first == "vertex_order"s) {
+			settings.vertex_order = ReadVertexOrder(s.second.AsString());
+		}
 		req_handler_.AddRoutingSettings(move(settings));
 	}
 }
 
+router::enRouterType JsonReader::ReadRouterType(const string& type) const {
+	if (type == "all_pairs"s) {
+		return router::enRouterType::ALL_PAIRS;
+	}
+	if (type == "dijkstra"s) {
+		return router::enRouterType::DIJKSTRA;
+	}
+	if (type == "contraction_hierarchies"s) {
+		return router::enRouterType::CONTRACTION_HIERARCHIES;
+	}
+	if (type == "astar"s) {
+		return router::enRouterType::ASTAR;
+	}
+	if (type == "bidirectional"s) {
+		return router::enRouterType::BIDIRECTIONAL;
+	}
+	if (type == "lazy_rows"s) {
+		return router::enRouterType::LAZY_ROWS;
+	}
+	if (type == "hub_labels"s) {
+		return router::enRouterType::HUB_LABELS;
+	}
+	throw invalid_argument("Invalid document: Unknown router type "s + type);
+}
+
+router::enGraphModel JsonReader::ReadGraphModel(const string& model) const {
+	if (model == "stop_pairs"s) {
+		return router::enGraphModel::STOP_PAIRS;
+	}
+	if (model == "lines"s) {
+		return router::enGraphModel::LINES;
+	}
+	throw invalid_argument("Invalid document: Unknown graph model "s + model);
+}
+
+router::enVertexOrder JsonReader::ReadVertexOrder(const string& order) const {
+	if (order == "insertion"s) {
+		return router::enVertexOrder::INSERTION;
+	}
+	if (order == "hilbert"s) {
+		return router::enVertexOrder::HILBERT;
+	}
+	if (order == "rcm"s) {
+		return router::enVertexOrder::RCM;
+	}
+	throw invalid_argument("Invalid document: Unknown vertex order "s + order);
+}
+
 void JsonReader::ReadRenderSettings(Dict settings) const {
 	RenderSettings draw_settings;
 	for (auto s : settings) {
@@ -241,13 +310,76 @@ void JsonReader::ReadStatReqs(Array stat_reqs) {
 			if (req.AsDict().count("from"s)) {
 				string from = req.AsDict().at("from"s).AsString();
 				string to = req.AsDict().at("to"s).AsString();
+				bool pareto = req.AsDict().count("pareto"s) && req.AsDict().at("pareto"s).AsBool();
 				req_handler_.AddStatRequest(
-					{ id, enStatRequestsType::ROUTE, {}, from, to }
+					{ id, enStatRequestsType::ROUTE, {}, from, to, pareto }
 				);
 			}
 			continue;
 		}
 
+		if (type == "Isochrone"s) {
+			StatRequest isochrone{ id, enStatRequestsType::ISOCHRONE };
+			if (req.AsDict().count("from"s)) {
+				isochrone.from = req.AsDict().at("from"s).AsString();
+			}
+			if (req.AsDict().count("max_time"s)) {
+				isochrone.max_time = req.AsDict().at("max_time"s).AsDouble();
+			}
+			req_handler_.AddStatRequest(move(isochrone));
+			continue;
+		}
+
+		if (type == "Matrix"s) {
+			StatRequest matrix{ id, enStatRequestsType::MATRIX };
+			if (req.AsDict().count("from"s)) {
+				for (const auto& stop : req.AsDict().at("from"s).AsArray()) {
+					matrix.from_stops.push_back(stop.AsString());
+				}
+			}
+			if (req.AsDict().count("to"s)) {
+				for (const auto& stop : req.AsDict().at("to"s).AsArray()) {
+					matrix.to_stops.push_back(stop.AsString());
+				}
+			}
+			req_handler_.AddStatRequest(move(matrix));
+			continue;
+		}
+
+		if (type == "NearestStops"s || type == "StopsWithin"s) {
+			StatRequest nearby{ id, type == "NearestStops"s
+				? enStatRequestsType::NEAREST_STOPS : enStatRequestsType::STOPS_WITHIN };
+			if (req.AsDict().count("latitude"s)) {
+				nearby.coord.lat = req.AsDict().at("latitude"s).AsDouble();
+			}
+			if (req.AsDict().count("longitude"s)) {
+				nearby.coord.lng = req.AsDict().at("longitude"s).AsDouble();
+			}
+			if (req.AsDict().count("count"s)) {
+				nearby.count = max(req.AsDict().at("count"s).AsInt(), 0);
+			}
+			if (req.AsDict().count("radius"s)) {
+				nearby.radius = req.AsDict().at("radius"s).AsDouble();
+			}
+			req_handler_.AddStatRequest(move(nearby));
+			continue;
+		}
+
+		if (type == "StopSearch"s) {
+			StatRequest search{ id, enStatRequestsType::STOP_SEARCH };
+			if (req.AsDict().count("query"s)) {
+				search.name = req.AsDict().at("query"s).AsString();
+			}
+			if (req.AsDict().count("count"s)) {
+				search.count = max(req.AsDict().at("count"s).AsInt(), 0);
+			}
+			if (req.AsDict().count("max_edits"s)) {
+				search.max_edits = max(req.AsDict().at("max_edits"s).AsInt(), 0);
+			}
+			req_handler_.AddStatRequest(move(search));
+			continue;
+		}
+
 		string name;
 		if (req.AsDict().count("name"s)) {
 			name = req.AsDict().at("name"s).AsString();
@@ -32,14 +32,14 @@ class JsonReader {
         Node operator()(router::WaitItem wait) const {
             return Node(Builder{}.StartDict()
                 .Key("type"s).Value("Wait"s)
-                .Key("stop_name"s).Value(std::string(wait.stop_name))
+                .Key("stop_name"s).Value(wait.stop->name)
                 .Key("time"s).Value(wait.time)
                 .EndDict().Build());
         }
         Node operator()(router::BusItem bus) const {
             return Node(Builder{}.StartDict()
                 .Key("type"s).Value("Bus"s)
-                .Key("bus"s).Value(std::string(bus.bus_name))
+                .Key("bus"s).Value(bus.bus->name)
                 .Key("span_count"s).Value(bus.span_count)
                 .Key("time"s).Value(bus.time)
                 .EndDict().Build());
@@ -50,6 +50,14 @@ class JsonReader {
         std::ostream& out = std::cout;
         int id_ = 0;
 
+        static Array PrintItems(const router::OptimalRoute& route) {
+            Array items{};
+            for (const auto& item : route.items) {
+                items.push_back(std::visit(RouteItemsPrinter{}, item));
+            }
+            return items;
+        }
+
         Node operator()(std::monostate) const {
             return Node(Dict{});
         }
@@ -71,24 +79,15 @@ class JsonReader {
             return response;
         }
         Node operator()(std::optional<StopBuses> buses) const {
-            std::vector<std::string> buses_list{};
             Node response{};
             if (buses) {
-                if (buses.value()) {
-                    for (auto bus : *buses.value()) {
-                        buses_list.push_back(Node(bus->name).AsString());
-                        std::sort(buses_list.begin(), buses_list.end());
-                    }
-                    Array sorted(std::begin(buses_list), std::end(buses_list));
-                    response = Builder{}.StartDict().Key("request_id"s).Value(id_)
-                        .Key("buses"s).Value(sorted)
-                        .EndDict().Build();
-                }
-                else {
-                    response = Builder{}.StartDict().Key("request_id"s).Value(id_)
-                        .Key("buses"s).Value(Array{})
-                        .EndDict().Build();
+                Array buses_list;
+                for (auto bus : *buses) {
+                    buses_list.push_back(Node(std::string(bus)));
                 }
+                response = Builder{}.StartDict().Key("request_id"s).Value(id_)
+                    .Key("buses"s).Value(buses_list)
+                    .EndDict().Build();
             }
             else {
                 response = Builder{}.StartDict().Key("request_id"s).Value(id_)
@@ -115,9 +114,7 @@ class JsonReader {
                     .EndDict().Build();
             }
             else {
-                for (auto item : (*route).items) {
-                    items.push_back(std::visit(RouteItemsPrinter{}, item));
-                }
+                items = PrintItems(*route);
                 response = Builder{}.StartDict().Key("request_id"s).Value(id_)
                     .Key("total_time"s).Value((*route).total_time)
                     .Key("items"s).Value(items)
@@ -125,6 +122,100 @@ class JsonReader {
             }
             return response;
         }
+        Node operator()(std::optional<std::vector<router::ReachableStop>> reachable) const {
+            Node response{};
+            if (!reachable) {
+                response = Builder{}.StartDict().Key("request_id"s).Value(id_)
+                    .Key("error_message"s).Value("not found"s)
+                    .EndDict().Build();
+            }
+            else {
+                Array stops{};
+                for (const auto& reachable_stop : *reachable) {
+                    stops.push_back(Builder{}.StartDict()
+                        .Key("stop_name"s).Value(reachable_stop.stop->name)
+                        .Key("time"s).Value(reachable_stop.time)
+                        .EndDict().Build());
+                }
+                response = Builder{}.StartDict().Key("request_id"s).Value(id_)
+                    .Key("stops"s).Value(stops)
+                    .EndDict().Build();
+            }
+            return response;
+        }
+        Node operator()(std::optional<std::vector<router::ParetoOption>> options) const {
+            Node response{};
+            if (!options) {
+                response = Builder{}.StartDict().Key("request_id"s).Value(id_)
+                    .Key("error_message"s).Value("not found"s)
+                    .EndDict().Build();
+            }
+            else {
+                Array routes{};
+                for (const auto& option : *options) {
+                    routes.push_back(Builder{}.StartDict()
+                        .Key("transfers"s).Value(option.transfers)
+                        .Key("total_time"s).Value(option.route.total_time)
+                        .Key("items"s).Value(PrintItems(option.route))
+                        .EndDict().Build());
+                }
+                response = Builder{}.StartDict().Key("request_id"s).Value(id_)
+                    .Key("routes"s).Value(routes)
+                    .EndDict().Build();
+            }
+            return response;
+        }
+        Node operator()(const std::vector<NearbyStop>& nearby) const {
+            Array stops{};
+            stops.reserve(nearby.size());
+            for (const auto& nearby_stop : nearby) {
+                stops.push_back(Builder{}.StartDict()
+                    .Key("stop_name"s).Value(nearby_stop.stop->name)
+                    .Key("distance"s).Value(nearby_stop.distance)
+                    .EndDict().Build());
+            }
+            return Builder{}.StartDict().Key("request_id"s).Value(id_)
+                .Key("stops"s).Value(std::move(stops))
+                .EndDict().Build();
+        }
+        Node operator()(const std::vector<StopMatch>& found) const {
+            Array stops{};
+            stops.reserve(found.size());
+            for (const auto& match : found) {
+                stops.push_back(Builder{}.StartDict()
+                    .Key("stop_name"s).Value(match.stop->name)
+                    .Key("edits"s).Value(static_cast<int>(match.edits))
+                    .EndDict().Build());
+            }
+            return Builder{}.StartDict().Key("request_id"s).Value(id_)
+                .Key("stops"s).Value(std::move(stops))
+                .EndDict().Build();
+        }
+        // только числа по строкам, без маршрутов; null - маршрута нет
+        Node operator()(std::optional<router::RouteTimes> times) const {
+            Node response{};
+            if (!times) {
+                response = Builder{}.StartDict().Key("request_id"s).Value(id_)
+                    .Key("error_message"s).Value("not found"s)
+                    .EndDict().Build();
+            }
+            else {
+                Array rows{};
+                rows.reserve(times->size());
+                for (const auto& times_row : *times) {
+                    Array row{};
+                    row.reserve(times_row.size());
+                    for (const auto& time : times_row) {
+                        row.push_back(time ? Node(*time) : Node(nullptr));
+                    }
+                    rows.push_back(std::move(row));
+                }
+                response = Builder{}.StartDict().Key("request_id"s).Value(id_)
+                    .Key("times"s).Value(std::move(rows))
+                    .EndDict().Build();
+            }
+            return response;
+        }
     };
 
 public:
@@ -139,6 +230,9 @@ private:
     void ReadStatReqs(Array stat_reqs);
     void ReadRenderSettings(Dict base_reqs) const;
     void ReadRoutingSettings(Dict json) const;
+    router::enRouterType ReadRouterType(const std::string& type) const;
+    router::enGraphModel ReadGraphModel(const std::string& model) const;
+    router::enVertexOrder ReadVertexOrder(const std::string& order) const;
     void ReadSerializationSettings(Dict serialize_req);
     RequestHandler& req_handler_;
 };
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "dijkstra_router.h"
+#include "lru_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Строки таблицы маршрутов строятся при первом запросе из вершины и хранятся,
+// пока не будут вытеснены давно не использованными строками
+template <typename Weight>
+class LazyRouter {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+
+    LazyRouter(const Graph& graph, size_t rows_capacity);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    std::optional<Weight> BuildRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const;
+
+    // Граф дополнен рёбрами с номерами от first_edge: вытесняются только строки,
+    // из которых достижимо начало хотя бы одного нового ребра
+    void Update(EdgeId first_edge);
+
+private:
+    static constexpr Weight NO_ROUTE = std::numeric_limits<Weight>::infinity();
+    static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+
+    // строка таблицы: веса путей из вершины и последние рёбра путей
+    struct Row {
+        std::vector<Weight> weights;
+        std::vector<uint32_t> prev_edges;
+    };
+    using RowPtr = std::shared_ptr<const Row>;
+
+    RowPtr GetRow(VertexId from) const;
+    RowPtr BuildRow(VertexId from) const;
+
+    const Graph& graph_;
+    DijkstraRouter<Weight> dijkstra_router_;
+    mutable std::mutex rows_mutex_;
+    mutable cache::LruCache<VertexId, RowPtr> rows_;
+};
+
+template <typename Weight>
+LazyRouter<Weight>::LazyRouter(const Graph& graph, size_t rows_capacity)
+    : graph_(graph)
+    , dijkstra_router_(graph)
+    , rows_(rows_capacity)
+{
+    if (graph.GetEdgeCount() >= NO_EDGE) {
+        throw std::length_error("Too many edges for the routes table");
+    }
+}
+
+template <typename Weight>
+std::optional<typename LazyRouter<Weight>::RouteInfo> LazyRouter<Weight>::BuildRoute(VertexId from,
+                                                                                     VertexId to) const {
+    std::vector<EdgeId> edges;
+    if (const auto weight = BuildRoute(from, to, edges)) {
+        return RouteInfo{*weight, std::move(edges)};
+    }
+    return std::nullopt;
+}
+
+template <typename Weight>
+std::optional<Weight> LazyRouter<Weight>::BuildRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const {
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    // строка удерживается указателем, даже если её вытеснят из кэша во время поиска
+    const RowPtr row = GetRow(from);
+    edges.clear();
+    // строки, построенные до добавления вершин, короче: новые вершины из них недостижимы
+    if (to >= row->weights.size() || row->weights[to] == NO_ROUTE) {
+        return std::nullopt;
+    }
+    for (uint32_t edge_id = row->prev_edges[to];
+         edge_id != NO_EDGE;
+         edge_id = row->prev_edges[graph_.GetEdge(edge_id).from])
+    {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return row->weights[to];
+}
+
+template <typename Weight>
+void LazyRouter<Weight>::Update(EdgeId first_edge) {
+    if (graph_.GetEdgeCount() >= NO_EDGE) {
+        throw std::length_error("Too many edges for the routes table");
+    }
+    std::vector<VertexId> tails;
+    for (EdgeId edge_id = first_edge; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        tails.push_back(graph_.GetEdge(edge_id).from);
+    }
+    std::lock_guard lock(rows_mutex_);
+    rows_.EraseIf([&tails](VertexId, const RowPtr& row) {
+        return std::any_of(tails.begin(), tails.end(), [&row](VertexId tail) {
+            return tail < row->weights.size() && row->weights[tail] != NO_ROUTE;
+        });
+    });
+}
+
+template <typename Weight>
+typename LazyRouter<Weight>::RowPtr LazyRouter<Weight>::GetRow(VertexId from) const {
+    {
+        std::lock_guard lock(rows_mutex_);
+        if (const RowPtr* row = rows_.Find(from)) {
+            return *row;
+        }
+    }
+    // строка строится без блокировки, чтобы не задерживать запросы из других вершин
+    RowPtr row = BuildRow(from);
+    std::lock_guard lock(rows_mutex_);
+    rows_.Put(from, row);
+    return row;
+}
+
+template <typename Weight>
+typename LazyRouter<Weight>::RowPtr LazyRouter<Weight>::BuildRow(VertexId from) const {
+    const auto tree = dijkstra_router_.BuildRoutesTree(from);
+    auto row = std::make_shared<Row>();
+    row->weights.resize(tree.weights.size(), NO_ROUTE);
+    row->prev_edges.resize(tree.prev_edges.size(), NO_EDGE);
+    for (const VertexId vertex : tree.touched) {
+        row->weights[vertex] = tree.weights[vertex];
+        if (tree.prev_edges[vertex] != SearchSpace<Weight>::NO_EDGE) {
+            row->prev_edges[vertex] = static_cast<uint32_t>(tree.prev_edges[vertex]);
+        }
+    }
+    return row;
+}
+
+}  // namespace graph
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace cache {
+
+// Кэш ограниченного размера с вытеснением давно не использованных элементов.
+// Синхронизация доступа из нескольких потоков - на стороне владельца кэша
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+public:
+    explicit LruCache(size_t capacity = 0)
+        : capacity_(capacity) {
+    }
+
+    // при попадании элемент становится самым свежим
+    const Value* Find(const Key& key) {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return nullptr;
+        }
+        items_.splice(items_.begin(), items_, it->second);
+        return &it->second->second;
+    }
+
+    void Put(const Key& key, Value value) {
+        if (capacity_ == 0) {
+            return;
+        }
+        if (auto it = index_.find(key); it != index_.end()) {
+            it->second->second = std::move(value);
+            items_.splice(items_.begin(), items_, it->second);
+            return;
+        }
+        if (items_.size() == capacity_) {
+            index_.erase(items_.back().first);
+            items_.pop_back();
+        }
+        items_.emplace_front(key, std::move(value));
+        index_[key] = items_.begin();
+    }
+
+    template <typename Predicate>
+    void EraseIf(Predicate predicate) {
+        for (auto it = items_.begin(); it != items_.end();) {
+            if (predicate(it->first, it->second)) {
+                index_.erase(it->first);
+                it = items_.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    void Clear() {
+        index_.clear();
+        items_.clear();
+    }
+
+    size_t GetSize() const {
+        return items_.size();
+    }
+
+    size_t GetCapacity() const {
+        return capacity_;
+    }
+
+    void SetCapacity(size_t capacity) {
+        capacity_ = capacity;
+        while (items_.size() > capacity_) {
+            index_.erase(items_.back().first);
+            items_.pop_back();
+        }
+    }
+
+private:
+    using Items = std::list<std::pair<Key, Value>>;
+
+    size_t capacity_;
+    // от самого свежего элемента к самому старому
+    Items items_;
+    std::unordered_map<Key, typename Items::iterator, Hash> index_;
+};
+
+}  // namespace cache
@@ -11,7 +11,7 @@
 using namespace std::literals;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|update_base|process_requests]\n"sv;
 }
 
 int main(int argc, char* argv[]) {
@@ -31,6 +31,16 @@ int main(int argc, char* argv[]) {
         req_handler.ProcessBaseCreateRequests();
         req_handler.SerializeBase();
     }
+    else if (mode == "update_base"sv) {
+        // add stops and buses to an existing base
+        transport_db::TransportCatalogue db;
+        in::RequestHandler req_handler(db);
+        in::JsonReader json(req_handler);
+        json.ReadDocument(std::cin);
+        req_handler.DeserializeBase();
+        req_handler.ProcessBaseUpdateRequests();
+        req_handler.SerializeBase();
+    }
     else if (mode == "process_requests"sv) {
         // process requests here
         transport_db::TransportCatalogue db;
@@ -9,6 +9,34 @@ void MapRenderer::SetRenderSettings(optional<RenderSettings> settings) {
     }
 }
 
+MapBuses MapRenderer::CoordinatesToPoints(const vector<Stop>& stops, const vector<Bus>& buses) {
+    vector<geo::Coordinates> all_stops_coord;
+    all_stops_coord.reserve(1000);
+
+    for (const auto& bus : buses) {
+        for (const StopId stop : bus.route) {
+            all_stops_coord.push_back(stops[stop].coord);
+        }
+    }
+    SphereProjector projector(
+        all_stops_coord.cbegin(), all_stops_coord.cend(),
+        settings_.width, settings_.height, settings_.padding
+    );
+
+    MapBuses map_buses;
+    for (const auto& bus : buses) {
+        if (bus.route.empty()) continue;
+        RouteAttr route;
+        for (const StopId stop : bus.route) {
+            route.stops.push_back({ stops[stop].name, projector(stops[stop].coord) });
+            route.is_roundtrip = bus.is_roundtrip;
+        }
+        map_buses[bus.name] = std::move(route);
+    }
+
+    return map_buses;
+}
+
 vector<Polyline> MapRenderer::RenderRouteLines(MapBuses& buses) {
     vector<Polyline> route_lines;
     for (auto& bus : buses) {
@@ -150,8 +150,7 @@ public:
     MapRenderer() = default;
 
     void SetRenderSettings(std::optional<RenderSettings> settings);
-    template<typename Container>
-    MapBuses CoordinatesToPoints(Container buses);
+    MapBuses CoordinatesToPoints(const std::vector<Stop>& stops, const std::vector<Bus>& buses);
 
     std::vector<svg::Polyline> RenderRouteLines(MapBuses& buses);
     std::vector<svg::Text> RenderRouteNames(MapBuses& buses);
@@ -164,32 +163,3 @@ private:
     std::vector<svg::Text> DrawText(const StopNamesToPoints& stops);
     RenderSettings settings_{};
 };
-
-template<typename Container>
-MapBuses MapRenderer::CoordinatesToPoints(Container buses) {
-    std::vector<geo::Coordinates> all_stops_coord;
-    all_stops_coord.reserve(1000);
-
-    for (const auto& bus : *buses) {
-        for (const auto& stop : bus.second->route) {
-            all_stops_coord.push_back(stop->coord);
-        }
-    }
-    SphereProjector projector(
-        all_stops_coord.cbegin(), all_stops_coord.cend(),
-        settings_.width, settings_.height, settings_.padding
-    );
-
-    MapBuses map_buses;
-    for (const auto& bus : *buses) {
-        if (bus.second->route.empty()) continue;
-        RouteAttr route;
-        for (const auto& stop : bus.second->route) {
-            route.stops.push_back({ stop->name, projector(stop->coord) });
-            route.is_roundtrip = bus.second->is_roundtrip;
-        }
-        map_buses[bus.first] = std::move(route);
-    }
-
-    return map_buses;
-}
\ No newline at end of file
@@ -1,5 +1,10 @@
 #include "request_handler.h"
 
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <unordered_set>
+
 using namespace std;
 using namespace in;
 
@@ -17,7 +22,7 @@ RequestHandler::RequestHandler(transport_db::TransportCatalogue& db,
 	stops_requests_.reserve(1000);
 }
 
-void RequestHandler::AddStopRequest(Stop stop) {
+void RequestHandler::AddStopRequest(StopInfo stop) {
 	stops_requests_.push_back(move(stop));
 }
 
@@ -44,6 +49,9 @@ void RequestHandler::AddSerializeSettings(string settings) {
 void RequestHandler::ProcessBaseCreateRequests() {
 	ProcessStopRequests();
 	ProcessBusRequests();
+	db_.ComputeRouteStats(GetBuildThreadCount());
+	db_.BuildStopsIndex();
+	db_.BuildStopNamesIndex();
 	if (routing_settings_.has_value()) {
 		router_ = make_unique<router::TransportRouter>(db_, routing_settings_.value());
 		router_->InitGraph();
@@ -51,71 +59,158 @@ void RequestHandler::ProcessBaseCreateRequests() {
 	}
 }
 
+// Обновление проверяется целиком до изменения базы: повтор имени, расстояние или автобус
+// через неизвестную остановку отклоняют всё обновление, а не дают неполную базу
+void RequestHandler::ProcessBaseUpdateRequests() {
+	unordered_set<string_view> new_stops;
+	for (const auto& stop : stops_requests_) {
+		if (db_.FindStop(stop.name) != nullptr || !new_stops.insert(stop.name).second) {
+			throw invalid_argument("Stop "s + stop.name + " already exists"s);
+		}
+	}
+	auto is_known_stop = [&](const string& name) {
+		return db_.FindStop(name) != nullptr || new_stops.count(name) > 0;
+	};
+	for (const auto& stop : stops_requests_) {
+		for (const auto& distance : stop.road_distances) {
+			if (!is_known_stop(distance.first)) {
+				throw invalid_argument("Stop "s + stop.name + ": road distance to unknown stop "s + distance.first);
+			}
+		}
+	}
+	unordered_set<string_view> new_buses;
+	for (const auto& bus : buses_requests_) {
+		if (db_.FindBus(bus.name) != nullptr || !new_buses.insert(bus.name).second) {
+			throw invalid_argument("Bus "s + bus.name + " already exists"s);
+		}
+		for (const auto& name : bus.stops) {
+			if (!is_known_stop(name)) {
+				throw invalid_argument("Bus "s + bus.name + ": unknown stop "s + name);
+			}
+		}
+	}
+
+	vector<string> stop_names;
+	for (const auto& stop : stops_requests_) {
+		stop_names.push_back(stop.name);
+	}
+	vector<string> bus_names;
+	for (const auto& bus : buses_requests_) {
+		bus_names.push_back(bus.name);
+	}
+	ProcessStopRequests();
+	ProcessBusRequests();
+	db_.ComputeRouteStats(GetBuildThreadCount());
+	// новые остановки могут попасть в любую часть деревьев, поэтому индексы строятся заново
+	if (!stop_names.empty()) {
+		db_.BuildStopsIndex();
+		db_.BuildStopNamesIndex();
+	}
+
+	if (router_ != nullptr) {
+		for (const auto& name : stop_names) {
+			router_->AddStop(db_.FindStop(name)->id);
+		}
+		for (const auto& name : bus_names) {
+			router_->AddBus(db_.FindBus(name)->id);
+		}
+	}
+}
+
+size_t RequestHandler::GetBuildThreadCount() const {
+	if (routing_settings_ && routing_settings_->build_threads > 0) {
+		return routing_settings_->build_threads;
+	}
+	return max(thread::hardware_concurrency(), 1u);
+}
+
 const std::vector<Response>& RequestHandler::GetResponses() {
 	return responses_;
 }
 
 optional<RouteStats> RequestHandler::GetBusStat(const string_view& bus_name) const {
-	optional<RouteStats> ret;
 	BusPtr bus = db_.FindBus(bus_name);
 	if (bus) {
-		RouteStats route_stats;
-		if (!bus->is_roundtrip) {
-			Bus tmp(*bus);
-			tmp.route.insert(tmp.route.end(), (tmp.route.rbegin() + 1), tmp.route.rend());
-			double geo_length = db_.ComputeGeoRouteDistance(&tmp);
-			route_stats.route_length = db_.ComputeRealRouteDistance(&tmp);
-			route_stats.stop_count = tmp.route.size();
-			route_stats.curvative = route_stats.route_length / geo_length;
-		}
-		else {
-			double geo_length = db_.ComputeGeoRouteDistance(bus);
-			route_stats.route_length = db_.ComputeRealRouteDistance(bus);
-			route_stats.stop_count = bus->route.size();
-			route_stats.curvative = route_stats.route_length / geo_length;
-		}
-
-		auto raw_route(bus->route);
-		sort(raw_route.begin(), raw_route.end());
-		auto last = unique(raw_route.begin(), raw_route.end());
-		vector<const Stop*> unique_stops(raw_route.begin(), last);
-		route_stats.unique_stop_count = unique_stops.size();
-
-		ret = route_stats;
+		return db_.GetRouteStats(bus->id);
 	}
-
-	return ret;
+	return nullopt;
 }
 
-AllBusesPtr RequestHandler::GetAllBuses() const {
-	return db_.GetAllBuses();
+optional<StopBuses> RequestHandler::GetBusesByStop(const string_view& stop_name) const {
+	const Stop* stop = db_.FindStop(stop_name);
+	if (stop == nullptr) {
+		return nullopt;
+	}
+	StopBuses buses;
+	for (BusId bus : db_.GetStopBuses(stop->id)) {
+		buses.push_back(db_.GetBus(bus).name);
+	}
+	sort(buses.begin(), buses.end());
+	return buses;
 }
 
-optional<StopBuses> RequestHandler::GetBusesByStop(const string_view& stop_name) const {
-	return db_.GetBusesNamesByStop(stop_name);
+svg::Document RequestHandler::RenderMap() const {
+	svg::Document doc;
+	map_renderer_->SetRenderSettings(render_settings_);
+	MapBuses map_buses = map_renderer_->CoordinatesToPoints(db_.GetStops(), db_.GetBuses());
+
+	// draw lines
+	auto pathes = map_renderer_->RenderRouteLines(map_buses);
+	for (auto lines : pathes)
+		doc.Add(move(lines));
+
+	// draw bus names
+	auto names = map_renderer_->RenderRouteNames(map_buses);
+	for (auto name : names)
+		doc.Add(move(name));
+
+	// draw stops
+	vector<svg::Circle> circles;
+	vector<svg::Text> stop_names;
+	map_renderer_->RenderStops(map_buses, &circles, &stop_names);
+	for (auto circle : circles)
+		doc.Add(move(circle));
+	for (auto stop_name : stop_names)
+		doc.Add(move(stop_name));
+
+	return doc;
 }
 
+// Имена переводятся в номера остановок на входе в справочник, неизвестные остановки пропускаются
 void RequestHandler::ProcessStopRequests() {
-	for (const auto& stop : stops_requests_) {
-		db_.AddStop(stop);
+	vector<StopId> ids;
+	ids.reserve(stops_requests_.size());
+	for (auto& stop : stops_requests_) {
+		ids.push_back(db_.AddStop(move(stop.name), stop.coord));
 	}
-	for (const auto& stop : stops_requests_) {
-		for (const auto& distance : stop.road_distances) {
-			db_.SetStopsDistance(stop.name, distance.first, distance.second);
+	for (size_t i = 0; i < stops_requests_.size(); ++i) {
+		for (const auto& distance : stops_requests_[i].road_distances) {
+			if (const Stop* to = db_.FindStop(distance.first)) {
+				db_.SetStopsDistance(ids[i], to->id, distance.second);
+			}
 		}
 	}
 	stops_requests_.clear();
 }
 
 void RequestHandler::ProcessBusRequests() {
-	for (const auto& bus : buses_requests_) {
-		db_.AddBus(bus.name, bus.stops, bus.is_roundtrip);
+	for (auto& bus : buses_requests_) {
+		vector<StopId> stops;
+		stops.reserve(bus.stops.size());
+		for (const auto& name : bus.stops) {
+			if (const Stop* stop = db_.FindStop(name)) {
+				stops.push_back(stop->id);
+			}
+		}
+		db_.AddBus(move(bus.name), move(stops), bus.is_roundtrip);
 	}
 	buses_requests_.clear();
 }
 
 void RequestHandler::ProcessStatRequests() {
-	for (auto req : stat_requests_) {
+	auto routes = ProcessRouteRequests();
+	for (size_t i = 0; i < stat_requests_.size(); ++i) {
+		auto& req = stat_requests_[i];
 		if (req.type == enStatRequestsType::BUS) {
 			responses_.push_back({ req.id, GetBusStat(move(req.name)) });
 		}
@@ -126,16 +221,104 @@ void RequestHandler::ProcessStatRequests() {
 			if (map_renderer_ == nullptr) {
 				map_renderer_ = make_unique<MapRenderer>();
 			}
-			auto map = make_shared<svg::Document>(RenderMap(GetAllBuses()));
+			auto map = make_shared<svg::Document>(RenderMap());
 			responses_.push_back({ req.id, move(map) });
 		}
+		else if (router_ == nullptr && (req.type == enStatRequestsType::ROUTE
+			|| req.type == enStatRequestsType::ISOCHRONE || req.type == enStatRequestsType::MATRIX)) {
+			// в базе нет маршрутизации
+			responses_.push_back({ req.id, optional<router::OptimalRoute>{} });
+		}
+		else if (req.type == enStatRequestsType::ROUTE && req.pareto) {
+			responses_.push_back({ req.id, router_->GetParetoRoutes(req.from, req.to) });
+		}
 		else if (req.type == enStatRequestsType::ROUTE) {
-			responses_.push_back({ req.id, move(router_->GetOptimalRoute(move(req.from), move(req.to))) });
+			responses_.push_back({ req.id, move(routes[i]) });
+		}
+		else if (req.type == enStatRequestsType::ISOCHRONE) {
+			responses_.push_back({ req.id, router_->GetReachableStops(req.from, req.max_time) });
+		}
+		else if (req.type == enStatRequestsType::MATRIX) {
+			vector<string_view> from(req.from_stops.begin(), req.from_stops.end());
+			vector<string_view> to(req.to_stops.begin(), req.to_stops.end());
+			responses_.push_back({ req.id, router_->GetRouteTimes(from, to) });
+		}
+		else if (req.type == enStatRequestsType::NEAREST_STOPS) {
+			responses_.push_back({ req.id, db_.FindNearestStops(req.coord, req.count) });
+		}
+		else if (req.type == enStatRequestsType::STOPS_WITHIN) {
+			responses_.push_back({ req.id, db_.FindStopsWithin(req.coord, req.radius) });
+		}
+		else if (req.type == enStatRequestsType::STOP_SEARCH) {
+			responses_.push_back({ req.id, db_.FindStopsByName(req.name, req.count, req.max_edits) });
 		}
 	}
 	stat_requests_.clear();
 }
 
+vector<optional<router::OptimalRoute>> RequestHandler::ProcessRouteRequests() {
+	vector<optional<router::OptimalRoute>> routes(stat_requests_.size());
+	if (router_ == nullptr) {
+		return routes;
+	}
+	// номера запросов Route, сгруппированные по остановке отправления
+	unordered_map<string_view, vector<size_t>> requests_by_origin;
+	for (size_t i = 0; i < stat_requests_.size(); ++i) {
+		if (stat_requests_[i].type == enStatRequestsType::ROUTE && !stat_requests_[i].pareto) {
+			requests_by_origin[stat_requests_[i].from].push_back(i);
+		}
+	}
+	vector<pair<string_view, vector<size_t>>> origins(requests_by_origin.begin(), requests_by_origin.end());
+
+	// маршрутизатор общий, у каждого потока свой буфер запроса; каждая группа пишет только свои ответы
+	atomic<size_t> next_origin = 0;
+	auto process_origins = [this, &origins, &routes, &next_origin]() {
+		router::RouteScratch scratch;
+		vector<string_view> to;
+		for (size_t origin = next_origin++; origin < origins.size(); origin = next_origin++) {
+			const auto& [from, indexes] = origins[origin];
+			to.clear();
+			for (size_t i : indexes) {
+				to.push_back(stat_requests_[i].to);
+			}
+			auto origin_routes = router_->GetOptimalRoutes(from, to, scratch);
+			for (size_t k = 0; k < indexes.size(); ++k) {
+				routes[indexes[k]] = move(origin_routes[k]);
+			}
+		}
+	};
+
+	const size_t thread_count = min(router_->GetQueryThreadCount(), max(origins.size(), size_t{ 1 }));
+	vector<exception_ptr> errors(thread_count);
+	vector<thread> threads;
+	threads.reserve(thread_count - 1);
+	for (size_t thread_index = 1; thread_index < thread_count; ++thread_index) {
+		threads.emplace_back([&process_origins, &errors, thread_index]() {
+			try {
+				process_origins();
+			}
+			catch (...) {
+				errors[thread_index] = current_exception();
+			}
+		});
+	}
+	try {
+		process_origins();
+	}
+	catch (...) {
+		errors[0] = current_exception();
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	for (const auto& error : errors) {
+		if (error) {
+			rethrow_exception(error);
+		}
+	}
+	return routes;
+}
+
 void RequestHandler::SerializeBase() {
 	if (serialize_settings_.has_value()) {
 		auto ms = render_settings_ ? &render_settings_.value() : nullptr;
@@ -156,9 +339,11 @@ void RequestHandler::DeserializeBase() {
 		routing_settings_ = routing_settings;
 		auto rs = &routing_settings_.value();
 
-		router_ = make_unique<router::TransportRouter>(db_);
-
-		ptb::Protobuffer ptb(db_, ms, rs, router_.get());
-		ptb.DeserializeDB(serialize_settings_.value().filename);
+		ptb::Protobuffer ptb(db_, ms, rs, nullptr);
+		router_ = ptb.DeserializeDB(serialize_settings_.value().filename);
+		// база создана без маршрутизации: обновление и сохранение базы её не добавляют
+		if (router_ == nullptr) {
+			routing_settings_.reset();
+		}
 	}
 }
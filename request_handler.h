@@ -16,6 +16,13 @@
 
 namespace in {
 
+// остановка из запроса: расстояния ещё заданы именами соседних остановок
+struct StopInfo {
+    std::string name{};
+    geo::Coordinates coord{};
+    std::unordered_map<std::string, int> road_distances{};
+};
+
 struct BusRoute {
     std::string name{};
     std::vector<std::string> stops{};
@@ -29,7 +36,12 @@ struct Response {
         std::optional<RouteStats>,
         std::optional<StopBuses>,
         std::shared_ptr<svg::Document>,
-        std::optional<router::OptimalRoute>> stat;
+        std::optional<router::OptimalRoute>,
+        std::optional<std::vector<router::ReachableStop>>,
+        std::optional<router::RouteTimes>,
+        std::optional<std::vector<router::ParetoOption>>,
+        std::vector<NearbyStop>,
+        std::vector<StopMatch>> stat;
 };
 
 class RequestHandler {
@@ -39,7 +51,7 @@ public:
         MapRenderer* map_renderer);
 
     // передаётся по значению, чтобы использовать семантику перемещения
-    void AddStopRequest(Stop stop);
+    void AddStopRequest(StopInfo stop);
     // передаётся по значению, чтобы использовать семантику перемещения
     void AddBusRequest(BusRoute bus);
     // передаётся по значению, чтобы использовать семантику перемещения
@@ -51,29 +63,34 @@ public:
     // передаётся по значению, чтобы использовать семантику перемещения
     void AddSerializeSettings(std::string settings);
     void ProcessBaseCreateRequests();
+    // Добавляет новые остановки и автобусы в загруженную базу без её полной перестройки
+    void ProcessBaseUpdateRequests();
     void ProcessStatRequests();
     void SerializeBase();
     void DeserializeBase();
     const std::vector<Response>& GetResponses();
 
-    // Возвращает информацию о маршруте (запрос Bus)
+    // Возвращает информацию о маршруте (запрос Bus), посчитанную при создании базы
     std::optional<RouteStats> GetBusStat(const std::string_view& bus_name) const;
-    AllBusesPtr GetAllBuses() const;
 
     // Возвращает маршруты, проходящие через
     std::optional<StopBuses> GetBusesByStop(const std::string_view& stop_name) const;
 
-    template<typename Container>
-    svg::Document RenderMap(Container buses) const;
+    svg::Document RenderMap() const;
 
 private:
     void ProcessStopRequests();
     void ProcessBusRequests();
+    // число потоков для расчётов при создании базы: build_threads из настроек маршрутизации
+    size_t GetBuildThreadCount() const;
+    // Запросы Route группируются по остановке отправления, группы распределяются между потоками,
+    // ответы - в порядке запросов
+    std::vector<std::optional<router::OptimalRoute>> ProcessRouteRequests();
 
     // RequestHandler использует агрегацию объектов "Транспортный Справочник" и "Визуализатор Карты"
     transport_db::TransportCatalogue& db_;
 
-    std::vector<Stop> stops_requests_;
+    std::vector<StopInfo> stops_requests_;
     std::vector<BusRoute> buses_requests_;
     std::vector<StatRequest> stat_requests_;
     std::vector<Response> responses_;
@@ -86,32 +103,4 @@ private:
     std::unique_ptr<router::TransportRouter> router_;
 };
 
-template<typename Container>
-svg::Document RequestHandler::RenderMap(Container buses) const {
-    svg::Document doc;
-    map_renderer_->SetRenderSettings(render_settings_);
-    MapBuses map_buses = map_renderer_->CoordinatesToPoints(buses);
-
-    // draw lines
-    auto pathes = map_renderer_->RenderRouteLines(map_buses);
-    for(auto lines : pathes)
-        doc.Add(std::move(lines));
-
-    // draw bus names
-    auto names = map_renderer_->RenderRouteNames(map_buses);
-    for (auto name : names)
-        doc.Add(std::move(name));
-
-    // draw stops
-    std::vector<svg::Circle> circles;
-    std::vector<svg::Text> stop_names;
-    map_renderer_->RenderStops(map_buses, &circles, &stop_names);
-    for (auto circle : circles)
-        doc.Add(std::move(circle));
-    for (auto stop_name : stop_names)
-        doc.Add(std::move(stop_name));
-
-    return doc;
-}
-
 } // namespace in
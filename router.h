@@ -4,18 +4,137 @@
 
 #include <algorithm>
 #include <cassert>
+#include <condition_variable>
 #include <cstdint>
 #include <iterator>
+#include <limits>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 namespace ptb { class Protobuffer; }
 
 namespace graph {
 
+namespace detail {
+
+class Barrier {
+public:
+    explicit Barrier(size_t count)
+        : count_(count) {
+    }
+
+    void ArriveAndWait() {
+        std::unique_lock lock(mutex_);
+        const size_t generation = generation_;
+        if (++arrived_ == count_) {
+            arrived_ = 0;
+            ++generation_;
+            condition_.notify_all();
+            return;
+        }
+        condition_.wait(lock, [this, generation] { return generation != generation_; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    const size_t count_;
+    size_t arrived_ = 0;
+    size_t generation_ = 0;
+};
+
+// Релаксация отрезка [begin, end) строки from через строку through: weights_from[j] заменяется
+// на weight_from + weights_through[j], если сумма строго меньше. Векторные версии выполняют
+// те же сложения и сравнения, что и скалярная, поэтому результат совпадает побитово.
+template <typename Weight>
+void RelaxRowSegmentScalar(Weight* weights_from, uint32_t* prev_edges_from,
+                           const Weight* weights_through, const uint32_t* prev_edges_through,
+                           Weight weight_from, uint32_t prev_edge_from, uint32_t no_edge,
+                           size_t begin, size_t end) {
+    for (size_t j = begin; j < end; ++j) {
+        const Weight candidate_weight = weight_from + weights_through[j];
+        if (candidate_weight < weights_from[j]) {
+            weights_from[j] = candidate_weight;
+            prev_edges_from[j] = prev_edges_through[j] != no_edge ? prev_edges_through[j] : prev_edge_from;
+        }
+    }
+}
+
+template <typename Weight>
+void RelaxRowSegment(Weight* weights_from, uint32_t* prev_edges_from,
+                     const Weight* weights_through, const uint32_t* prev_edges_through,
+                     Weight weight_from, uint32_t prev_edge_from, uint32_t no_edge,
+                     size_t begin, size_t end) {
+    RelaxRowSegmentScalar(weights_from, prev_edges_from, weights_through, prev_edges_through,
+                          weight_from, prev_edge_from, no_edge, begin, end);
+}
+
+#if defined(__AVX2__) || defined(__SSE2__)
+template <>
+inline void RelaxRowSegment<double>(double* weights_from, uint32_t* prev_edges_from,
+                                    const double* weights_through, const uint32_t* prev_edges_through,
+                                    double weight_from, uint32_t prev_edge_from, uint32_t no_edge,
+                                    size_t begin, size_t end) {
+#if defined(__AVX2__)
+    constexpr size_t LANES = 4;
+    using Vector = __m256d;
+    const Vector weight_from_v = _mm256_set1_pd(weight_from);
+    auto add = [](Vector lhs, Vector rhs) { return _mm256_add_pd(lhs, rhs); };
+    auto less = [](Vector lhs, Vector rhs) { return _mm256_cmp_pd(lhs, rhs, _CMP_LT_OQ); };
+    auto select = [](Vector mask, Vector if_true, Vector if_false) {
+        return _mm256_blendv_pd(if_false, if_true, mask);
+    };
+    auto load = [](const double* data) { return _mm256_loadu_pd(data); };
+    auto store = [](double* data, Vector value) { _mm256_storeu_pd(data, value); };
+    auto movemask = [](Vector mask) { return _mm256_movemask_pd(mask); };
+#else
+    constexpr size_t LANES = 2;
+    using Vector = __m128d;
+    const Vector weight_from_v = _mm_set1_pd(weight_from);
+    auto add = [](Vector lhs, Vector rhs) { return _mm_add_pd(lhs, rhs); };
+    auto less = [](Vector lhs, Vector rhs) { return _mm_cmplt_pd(lhs, rhs); };
+    auto select = [](Vector mask, Vector if_true, Vector if_false) {
+        return _mm_or_pd(_mm_and_pd(mask, if_true), _mm_andnot_pd(mask, if_false));
+    };
+    auto load = [](const double* data) { return _mm_loadu_pd(data); };
+    auto store = [](double* data, Vector value) { _mm_storeu_pd(data, value); };
+    auto movemask = [](Vector mask) { return _mm_movemask_pd(mask); };
+#endif
+
+    size_t j = begin;
+    for (; j + LANES <= end; j += LANES) {
+        const Vector candidate = add(weight_from_v, load(weights_through + j));
+        const Vector current = load(weights_from + j);
+        const Vector is_less = less(candidate, current);
+        const int mask = movemask(is_less);
+        if (mask == 0) {
+            continue;
+        }
+        store(weights_from + j, select(is_less, candidate, current));
+        // улучшения редки, поэтому предшественники обновляются поэлементно по маске сравнения
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            if (mask & (1 << lane)) {
+                prev_edges_from[j + lane] = prev_edges_through[j + lane] != no_edge
+                    ? prev_edges_through[j + lane] : prev_edge_from;
+            }
+        }
+    }
+    RelaxRowSegmentScalar(weights_from, prev_edges_from, weights_through, prev_edges_through,
+                          weight_from, prev_edge_from, no_edge, j, end);
+}
+#endif
+
+}  // namespace detail
+
 template <typename Weight>
 class Router {
 private:
@@ -23,7 +142,7 @@ private:
     using Graph = DirectedWeightedGraph<Weight>;
 
 public:
-    explicit Router(const Graph& graph);
+    explicit Router(const Graph& graph, size_t thread_count = 1);
 
     struct RouteInfo {
         Weight weight;
@@ -31,50 +150,109 @@ public:
     };
 
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // Рёбра пути записываются в буфер вызывающего, память которого переиспользуется между запросами
+    std::optional<Weight> BuildRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const;
+    // Только вес пути, без восстановления рёбер
+    std::optional<Weight> GetRouteWeight(VertexId from, VertexId to) const;
+
+    // Граф дополнен вершинами и рёбрами с номерами от first_edge. Любой новый кратчайший путь
+    // состоит из старых кратчайших путей и новых рёбер, стыкующихся в концах новых рёбер,
+    // поэтому достаточно шагов релаксации только через эти вершины: O(|S| * V^2) вместо O(V^3)
+    void Update(EdgeId first_edge);
 
 private:
-    struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
+    static_assert(std::numeric_limits<Weight>::has_infinity, "Weight should have an infinity value");
+    static constexpr Weight NO_ROUTE = std::numeric_limits<Weight>::infinity();
+    static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+    // ширина полосы столбцов: 12 КБ строки vertex_through при весах double
+    static constexpr size_t TILE_WIDTH = 1024;
+
+    // Таблица маршрутов V x V, хранимая построчно в двух плоских массивах:
+    // веса (NO_ROUTE - маршрута нет) и последние рёбра маршрутов (NO_EDGE - ребра нет)
+    struct RoutesInternalData {
+        size_t vertex_count = 0;
+        std::vector<Weight> weights;
+        std::vector<uint32_t> prev_edges;
+
+        size_t Index(VertexId from, VertexId to) const {
+            return from * vertex_count + to;
+        }
     };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
 
     void InitializeRoutesInternalData(const Graph& graph) {
         const size_t vertex_count = graph.GetVertexCount();
+        if (graph.GetEdgeCount() >= NO_EDGE) {
+            throw std::length_error("Too many edges for the routes table");
+        }
+        routes_internal_data_.vertex_count = vertex_count;
+        routes_internal_data_.weights.assign(vertex_count * vertex_count, NO_ROUTE);
+        routes_internal_data_.prev_edges.assign(vertex_count * vertex_count, NO_EDGE);
         for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
-            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
-                const auto& edge = graph.GetEdge(edge_id);
+            routes_internal_data_.weights[routes_internal_data_.Index(vertex, vertex)] = ZERO_WEIGHT;
+            for (const auto& edge : graph.GetIncidentEdges(vertex)) {
                 if (edge.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                const size_t index = routes_internal_data_.Index(vertex, edge.to);
+                if (routes_internal_data_.weights[index] == NO_ROUTE
+                    || routes_internal_data_.weights[index] > edge.weight) {
+                    routes_internal_data_.weights[index] = edge.weight;
+                    routes_internal_data_.prev_edges[index] = static_cast<uint32_t>(edge.id);
                 }
             }
         }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+    // Строки vertex_from и vertex_through не пересекаются, кроме случая vertex_from == vertex_through,
+    // в котором релаксация ничего не меняет. Несуществующие маршруты имеют бесконечный вес
+    // и не проходят сравнение, поэтому внутренний цикл не ветвится на их наличие.
+    // Строки обходятся полосами по TILE_WIDTH столбцов, чтобы полоса строки vertex_through
+    // оставалась в кэше L1 для всех строк vertex_from. Внутри шага vertex_through ячейки
+    // независимы, поэтому порядок обхода не влияет на результат.
+    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through,
+                                              VertexId vertex_from_begin, VertexId vertex_from_end) {
+        const Weight* weights_through = &routes_internal_data_.weights[vertex_through * vertex_count];
+        const uint32_t* prev_edges_through = &routes_internal_data_.prev_edges[vertex_through * vertex_count];
+        for (VertexId tile_begin = 0; tile_begin < vertex_count; tile_begin += TILE_WIDTH) {
+            const VertexId tile_end = std::min(vertex_count, tile_begin + TILE_WIDTH);
+            for (VertexId vertex_from = vertex_from_begin; vertex_from < vertex_from_end; ++vertex_from) {
+                Weight* weights_from = &routes_internal_data_.weights[vertex_from * vertex_count];
+                uint32_t* prev_edges_from = &routes_internal_data_.prev_edges[vertex_from * vertex_count];
+                const Weight weight_from = weights_from[vertex_through];
+                if (weight_from == NO_ROUTE) {
+                    continue;
+                }
+                detail::RelaxRowSegment(weights_from, prev_edges_from, weights_through, prev_edges_through,
+                                        weight_from, prev_edges_from[vertex_through], NO_EDGE,
+                                        tile_begin, tile_end);
+            }
         }
     }
 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                    }
-                }
+    // На шаге vertex_through строка vertex_through не меняется (вес пути в себя нулевой),
+    // поэтому строки можно релаксировать независимо, синхронизируясь только между шагами.
+    // Порядок операций над каждой ячейкой тот же, что и в однопоточной версии.
+    void RelaxRoutesInternalDataInParallel(size_t vertex_count, size_t thread_count) {
+        detail::Barrier barrier(thread_count);
+        const size_t rows_per_thread = (vertex_count + thread_count - 1) / thread_count;
+        auto relax_rows = [this, &barrier, vertex_count, rows_per_thread](size_t thread_index) {
+            const VertexId vertex_from_begin = std::min(vertex_count, thread_index * rows_per_thread);
+            const VertexId vertex_from_end = std::min(vertex_count, vertex_from_begin + rows_per_thread);
+            for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+                RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through,
+                                                     vertex_from_begin, vertex_from_end);
+                barrier.ArriveAndWait();
             }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(thread_count - 1);
+        for (size_t thread_index = 1; thread_index < thread_count; ++thread_index) {
+            threads.emplace_back(relax_rows, thread_index);
+        }
+        relax_rows(0);
+        for (auto& thread : threads) {
+            thread.join();
         }
     }
 
@@ -84,37 +262,110 @@ private:
 };
 
 template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+Router<Weight>::Router(const Graph& graph, size_t thread_count)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
 {
     InitializeRoutesInternalData(graph);
 
     const size_t vertex_count = graph.GetVertexCount();
+    thread_count = std::min(thread_count, vertex_count);
+    if (thread_count > 1) {
+        RelaxRoutesInternalDataInParallel(vertex_count, thread_count);
+        return;
+    }
+    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through, 0, vertex_count);
+    }
+}
+
+template <typename Weight>
+void Router<Weight>::Update(EdgeId first_edge) {
+    if (graph_.GetEdgeCount() >= NO_EDGE) {
+        throw std::length_error("Too many edges for the routes table");
+    }
+    const size_t old_vertex_count = routes_internal_data_.vertex_count;
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (vertex_count > old_vertex_count) {
+        RoutesInternalData data;
+        data.vertex_count = vertex_count;
+        data.weights.assign(vertex_count * vertex_count, NO_ROUTE);
+        data.prev_edges.assign(vertex_count * vertex_count, NO_EDGE);
+        for (VertexId from = 0; from < old_vertex_count; ++from) {
+            std::copy_n(&routes_internal_data_.weights[routes_internal_data_.Index(from, 0)], old_vertex_count,
+                        &data.weights[data.Index(from, 0)]);
+            std::copy_n(&routes_internal_data_.prev_edges[routes_internal_data_.Index(from, 0)], old_vertex_count,
+                        &data.prev_edges[data.Index(from, 0)]);
+        }
+        for (VertexId vertex = old_vertex_count; vertex < vertex_count; ++vertex) {
+            data.weights[data.Index(vertex, vertex)] = ZERO_WEIGHT;
+        }
+        routes_internal_data_ = std::move(data);
+    }
+
+    std::vector<bool> is_endpoint(vertex_count, false);
+    for (EdgeId edge_id = first_edge; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        const size_t index = routes_internal_data_.Index(edge.from, edge.to);
+        if (edge.weight < routes_internal_data_.weights[index]) {
+            routes_internal_data_.weights[index] = edge.weight;
+            routes_internal_data_.prev_edges[index] = static_cast<uint32_t>(edge_id);
+        }
+        is_endpoint[edge.from] = true;
+        is_endpoint[edge.to] = true;
+    }
     for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+        if (is_endpoint[vertex_through]) {
+            RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through, 0, vertex_count);
+        }
     }
 }
 
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                              VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+    std::vector<EdgeId> edges;
+    if (const auto weight = BuildRoute(from, to, edges)) {
+        return RouteInfo{*weight, std::move(edges)};
+    }
+    return std::nullopt;
+}
+
+template <typename Weight>
+std::optional<Weight> Router<Weight>::GetRouteWeight(VertexId from, VertexId to) const {
+    const size_t vertex_count = routes_internal_data_.vertex_count;
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const Weight weight = routes_internal_data_.weights[routes_internal_data_.Index(from, to)];
+    if (weight == NO_ROUTE) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
-    std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+    return weight;
+}
+
+template <typename Weight>
+std::optional<Weight> Router<Weight>::BuildRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const {
+    const size_t vertex_count = routes_internal_data_.vertex_count;
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    edges.clear();
+    const Weight weight = routes_internal_data_.weights[routes_internal_data_.Index(from, to)];
+    if (weight == NO_ROUTE) {
+        return std::nullopt;
+    }
+    for (uint32_t edge_id = routes_internal_data_.prev_edges[routes_internal_data_.Index(from, to)];
+         edge_id != NO_EDGE;
+         edge_id = routes_internal_data_.prev_edges[routes_internal_data_.Index(from, graph_.GetEdge(edge_id).from)])
     {
-        edges.push_back(*edge_id);
+        edges.push_back(edge_id);
     }
     std::reverse(edges.begin(), edges.end());
 
-    return RouteInfo{weight, std::move(edges)};
+    return weight;
 }
 
 }  // namespace graph
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <tuple>
+#include <vector>
+
+namespace graph {
+
+// Рабочие массивы поиска по графу из одной вершины. Выделяются при первом поиске и дальше
+// переиспользуются: Reset сбрасывает только вершины, которых коснулся предыдущий поиск
+template <typename Weight>
+struct SearchSpace {
+    static constexpr Weight NO_WEIGHT = std::numeric_limits<Weight>::infinity();
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+    // оценка веса всего пути через вершину, вес пути до вершины, вершина
+    using QueueItem = std::tuple<Weight, Weight, VertexId>;
+
+    // вес пути до вершины, NO_WEIGHT - вершина не достигнута
+    std::vector<Weight> weights;
+    // ребро, по которому достигнута вершина, NO_EDGE - у начала поиска
+    std::vector<EdgeId> prev_edges;
+    // читаются только у достигнутых вершин, поэтому не сбрасываются
+    std::vector<VertexId> prev_vertices;
+    std::vector<Weight> estimates;
+    std::vector<bool> is_target;
+    // вершины, у которых задан вес
+    std::vector<VertexId> touched;
+    // куча очереди поиска, минимум в начале
+    std::vector<QueueItem> queue;
+    // дуги пути для поисков, которые собирают его не из рёбер графа
+    std::vector<EdgeId> arcs;
+
+    void Reset(size_t vertex_count) {
+        for (const VertexId vertex : touched) {
+            weights[vertex] = NO_WEIGHT;
+            prev_edges[vertex] = NO_EDGE;
+        }
+        touched.clear();
+        queue.clear();
+        if (weights.size() != vertex_count) {
+            weights.resize(vertex_count, NO_WEIGHT);
+            prev_edges.resize(vertex_count, NO_EDGE);
+            prev_vertices.resize(vertex_count);
+            estimates.resize(vertex_count);
+            is_target.resize(vertex_count, false);
+        }
+    }
+
+    void SetWeight(VertexId vertex, Weight weight) {
+        if (weights[vertex] == NO_WEIGHT) {
+            touched.push_back(vertex);
+        }
+        weights[vertex] = weight;
+    }
+
+    bool IsReached(VertexId vertex) const {
+        return weights[vertex] != NO_WEIGHT;
+    }
+
+    void Push(QueueItem item) {
+        queue.push_back(item);
+        std::push_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+    }
+
+    QueueItem Pop() {
+        std::pop_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+        const QueueItem item = queue.back();
+        queue.pop_back();
+        return item;
+    }
+
+    const QueueItem& Top() const {
+        return queue.front();
+    }
+};
+
+}  // namespace graph
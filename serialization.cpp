@@ -1,5 +1,8 @@
 #include "serialization.h"
 
+#include <algorithm>
+#include <thread>
+
 using namespace std;
 
 namespace ptb {
@@ -7,40 +10,60 @@ namespace ptb {
 void Protobuffer::SerializeDB(std::string filename) {
 	pbf_db::TransportCatalogue base;
 	ofstream output(filename, ios::binary);
-	const deque<Stop>& stops = db_.stops_;
-	const deque<Bus>& buses = db_.buses_;
+	const vector<Stop>& stops = db_.stops_;
+	const vector<Bus>& buses = db_.buses_;
 	{
 		for (const Stop& stop : stops) {
 			pbf_db::Stop stop_pb;
-			uint64_t id_s = stop_name_to_id_.at(stop.name);
-			stop_pb.set_id(id_s);
+			stop_pb.set_id(stop.id);
 			stop_pb.set_name(stop.name);
 
 			pbf_db::Coordinates coord_out;
 			coord_out.set_lat(stop.coord.lat);
 			coord_out.set_lng(stop.coord.lng);
 			*stop_pb.mutable_coord() = coord_out;
-
-			for (const auto& distance : stop.road_distances) {
-				uint64_t id_d = stop_name_to_id_.at(distance.first);
-				(*stop_pb.mutable_road_distances())[id_d] = distance.second;
-			}
 			*base.add_stop() = move(stop_pb);
 		}
+		// расстояние хранится у остановки, от которой оно задано; остановки записаны по номерам
+		db_.stops_distance_.ForEach([&base](StopId from, StopId to, int distance) {
+			(*base.mutable_stop(from)->mutable_road_distances())[to] = distance;
+		});
 	}
 	{
 		for (const Bus& bus : buses) {
 			pbf_db::Bus bus_pb;
 			bus_pb.set_name(bus.name);
 			bus_pb.set_is_roundtrip(bus.is_roundtrip);
-			for (const auto& stop : bus.route) {
-				uint64_t id_d = stop_name_to_id_.at(stop->name);
-				bus_pb.add_route(id_d);
-			}
+			bus_pb.mutable_route()->Add(bus.route.begin(), bus.route.end());
+			const RouteStats& stats = db_.GetRouteStats(bus.id);
+			auto& stats_pb = *bus_pb.mutable_stats();
+			stats_pb.set_curvature(stats.curvative);
+			stats_pb.set_route_length(stats.route_length);
+			stats_pb.set_stop_count(stats.stop_count);
+			stats_pb.set_unique_stop_count(stats.unique_stop_count);
 			*base.add_bus() = move(bus_pb);
 		}
 	}
 
+	{
+		const auto& stops_index = db_.stops_index_;
+		auto& stops_index_pb = *base.mutable_stops_index();
+		stops_index_pb.mutable_stop()->Add(stops_index.tree_.begin(), stops_index.tree_.end());
+		stops_index_pb.set_axes(string(stops_index.axes_.begin(), stops_index.axes_.end()));
+	}
+	{
+		const auto& names_index = db_.stop_names_index_;
+		auto& names_index_pb = *base.mutable_stop_names_index();
+		names_index_pb.mutable_stop()->Add(names_index.stops_.begin(), names_index.stops_.end());
+		for (const auto& node : names_index.nodes_) {
+			names_index_pb.add_depth(node.depth);
+			names_index_pb.add_children_begin(node.children_begin);
+			names_index_pb.add_children_end(node.children_end);
+			names_index_pb.add_stops_begin(node.stops_begin);
+			names_index_pb.add_stops_end(node.stops_end);
+		}
+	}
+
 	if (render_settings_) {
 		*base.mutable_render_settings() = move(SerializeRenderSettings());
 	}
@@ -53,65 +76,72 @@ void Protobuffer::SerializeDB(std::string filename) {
 	base.SerializePartialToOstream(&output);
 }
 
-void Protobuffer::DeserializeDB(std::string filename) {
+unique_ptr<router::TransportRouter> Protobuffer::DeserializeDB(std::string filename) {
 	pbf_db::TransportCatalogue base;
-	map<string, const Stop*> name_to_stop_ptr_;
 	std::ifstream input(filename, ios::binary);
 
-	db_.stops_.clear();
-	db_.buses_.clear();
-	db_.stopname_to_stop_.clear();
-	db_.busname_to_bus_.clear();
-	db_.stopname_to_buses_.clear();
-	db_.stops_distance_.clear();
+	db_ = transport_db::TransportCatalogue{};
 
 	if (!base.ParseFromIstream(&input)) {
-		return;
+		return nullptr;
 	}
 
+	// номера остановок в базе - их позиции, поэтому совпадают с номерами в справочнике
 	for (const auto& stop : base.stop()) {
-		uint64_t id = stop.id();
-		string name = stop.name();
-		id_to_stop_name_[id] = name;
+		db_.AddStop(stop.name(), { stop.coord().lat(), stop.coord().lng() });
 	}
-
 	for (const auto& stop : base.stop()) {
-		Stop stop_;
-		stop_.name = stop.name();
-		stop_.coord.lat = stop.coord().lat();
-		stop_.coord.lng = stop.coord().lng();
-
 		for (const auto& distance : stop.road_distances()) {
-			string name = id_to_stop_name_.at(distance.first);
-			stop_.road_distances[name] = distance.second;
+			db_.SetStopsDistance(static_cast<StopId>(stop.id()), static_cast<StopId>(distance.first), distance.second);
 		}
-		auto& last_added = db_.stops_.emplace_back(stop_);
-		name_to_stop_ptr_[stop_.name] = &last_added;
-
-		db_.stopname_to_stop_.insert({ last_added.name, &last_added });
-		db_.stopname_to_buses_[last_added.name];
 	}
 
-	for (auto& stop : db_.stops_) {
-		for (auto& distance : stop.road_distances) {
-			db_.SetStopsDistance(stop.name, distance.first, distance.second);
+	bool has_stats = true;
+	for (const auto& bus : base.bus()) {
+		db_.AddBus(bus.name(), { bus.route().begin(), bus.route().end() }, bus.is_roundtrip());
+		has_stats = has_stats && bus.has_stats();
+	}
+	if (has_stats) {
+		for (const auto& bus : base.bus()) {
+			const auto& stats = bus.stats();
+			db_.route_stats_.push_back({ stats.curvature(), stats.route_length(),
+				static_cast<size_t>(stats.stop_count()), static_cast<size_t>(stats.unique_stop_count()) });
 		}
 	}
+	else {
+		// база создана до появления статистики в ней
+		db_.ComputeRouteStats(max(thread::hardware_concurrency(), 1u));
+	}
 
-	for (const auto& bus : base.bus()) {
-		Bus bus_;
-		bus_.name = bus.name();
-		bus_.is_roundtrip = bus.is_roundtrip();
-
-		for (const auto& stop : bus.route()) {
-			string name = id_to_stop_name_.at(stop);
-			bus_.route.push_back(name_to_stop_ptr_.at(name));
+	{
+		auto& stops_index = db_.stops_index_;
+		const auto& stops_index_pb = base.stops_index();
+		stops_index.tree_.assign(stops_index_pb.stop().begin(), stops_index_pb.stop().end());
+		stops_index.axes_.assign(stops_index_pb.axes().begin(), stops_index_pb.axes().end());
+		if (stops_index.IsBuilt(db_.stops_)) {
+			stops_index.ComputePoints(db_.stops_);
 		}
-		auto& last_added = db_.buses_.emplace_back(bus_);
-
-		db_.busname_to_bus_.insert({ last_added.name, &last_added });
-		for (auto stop : bus_.route) {
-			db_.stopname_to_buses_[stop->name].insert(&last_added);
+		else {
+			// база создана до появления индекса в ней
+			db_.BuildStopsIndex();
+		}
+	}
+	{
+		auto& names_index = db_.stop_names_index_;
+		const auto& names_index_pb = base.stop_names_index();
+		names_index.stops_.assign(names_index_pb.stop().begin(), names_index_pb.stop().end());
+		names_index.nodes_.resize(names_index_pb.depth_size());
+		for (size_t i = 0; i < names_index.nodes_.size(); ++i) {
+			names_index.nodes_[i] = { names_index_pb.depth(i),
+				names_index_pb.children_begin(i), names_index_pb.children_end(i),
+				names_index_pb.stops_begin(i), names_index_pb.stops_end(i) };
+		}
+		if (names_index.IsBuilt(db_.stops_)) {
+			names_index.ComputeFoldedNames(db_.stops_);
+		}
+		else {
+			// база создана до появления индекса в ней
+			db_.BuildStopNamesIndex();
 		}
 	}
 
@@ -119,13 +149,15 @@ void Protobuffer::DeserializeDB(std::string filename) {
 		DeserializeRenderSettings(move(*base.mutable_render_settings()));
 	}
 
-	if (base.has_graph()) {
-		DeserializeGraph(move(*base.mutable_graph()));
-	}
-
+	// граф и маршрутизатор пишутся только вместе с настройками маршрутизации
+	unique_ptr<router::TransportRouter> router;
 	if (base.has_router()) {
+		router = make_unique<router::TransportRouter>(db_);
+		router_ = router.get();
+		DeserializeGraph(move(*base.mutable_graph()));
 		DeserializeRouter(move(*base.mutable_router()));
 	}
+	return router;
 }
 
 // private section
@@ -229,45 +261,32 @@ void Protobuffer::DeserializeRenderSettings(pbf_db::RenderSettings in) {
 pbf_db::Graph Protobuffer::SerializeGraph() {
 	pbf_db::Graph out;
 
-	const auto& in = router_->graph_;
-
-	for (const auto& e : in->edges_) {
-		pbf_db::Edge edge_pbf;
-		edge_pbf.set_from(e.from);
-		edge_pbf.set_to(e.to);
-		edge_pbf.set_weight(e.weight);
-		*out.add_edges() = move(edge_pbf);
-	}
+	const auto& in = *router_->graph_;
 
-	for (const auto& lists : in->incidence_lists_) {
-		pbf_db::IncidenceList list_pbf;
-		for (auto edge_id : lists) {
-			list_pbf.add_edge_id(edge_id);
-		}
-		*out.add_incidence_lists() = move(list_pbf);
+	out.set_vertex_count(in.vertex_count_);
+	out.mutable_offsets()->Add(in.outgoing_.offsets.begin(), in.outgoing_.offsets.end());
+	for (const auto& record : in.outgoing_.records) {
+		out.add_to(record.to);
+		out.add_weights(record.weight);
+		out.add_edge_ids(record.id);
 	}
 
 	return out;
 }
 
 void Protobuffer::DeserializeGraph(pbf_db::Graph in) {
-	auto& out = router_->graph_;
+	auto& out = *router_->graph_;
 
-	for (const auto& edge_pbf : in.edges()) {
-		graph::Edge<double> edge;
-		edge.from = edge_pbf.from();
-		edge.to = edge_pbf.to();
-		edge.weight = edge_pbf.weight();
-		out->edges_.push_back(move(edge));
-	}
-
-	for (const auto& list_pbf : in.incidence_lists()) {
-		std::vector<size_t> list;
-		for (auto& edge_pbf : list_pbf.edge_id()) {
-			list.push_back(move(edge_pbf));
+	out.vertex_count_ = in.vertex_count();
+	out.edges_.resize(in.edge_ids_size());
+	for (graph::VertexId vertex = 0; vertex < out.vertex_count_; ++vertex) {
+		for (uint64_t i = in.offsets(vertex); i < in.offsets(vertex + 1); ++i) {
+			out.edges_.at(in.edge_ids(i)) = { vertex, in.to(i), in.weights(i) };
 		}
-		out->incidence_lists_.push_back(move(list));
 	}
+	// входящие рёбра не хранятся в базе, Freeze строит их по исходящим
+	out.frozen_ = false;
+	out.Freeze();
 }
 
 pbf_db::Router Protobuffer::SerializeRouter() {
@@ -277,45 +296,48 @@ pbf_db::Router Protobuffer::SerializeRouter() {
 		const auto& in = router_->settings_;
 		data.mutable_settings()->set_bus_wait_time(in.bus_wait_time);
 		data.mutable_settings()->set_bus_velocity(in.bus_velocity);
-	}
-	{ // router internal data
-		const auto& in = router_->router_;
-		for (const auto& edges : in->routes_internal_data_) {
-			pbf_db::EdgeInternalData edges_pbf;
-			for (const auto& edge : edges) {
-				pbf_db::OptionalRouteInternalData optional_edge_pbf;
-				if (edge.has_value()) {
-					pbf_db::RouteInternalData edge_pbf;
-					edge_pbf.set_weight(edge.value().weight);
-					if (edge.value().prev_edge.has_value()) {
-						pbf_db::PrevEdge prev_edge_pbf;
-						prev_edge_pbf.set_value(edge.value().prev_edge.value());
-						*edge_pbf.mutable_prev_edge() = move(prev_edge_pbf);
-					}
-					*optional_edge_pbf.mutable_route_internal_data() = move(edge_pbf);
-				}
-				*edges_pbf.add_edge() = move(optional_edge_pbf);
-			}
-			*data.add_edges() = move(edges_pbf);
-		}
+		data.mutable_settings()->set_router_type(static_cast<int32_t>(in.router_type));
+		data.mutable_settings()->set_route_cache_size(in.route_cache_size);
+		data.mutable_settings()->set_route_rows_limit(in.route_rows_limit);
+		data.mutable_settings()->set_graph_model(static_cast<int32_t>(in.graph_model));
+		data.mutable_settings()->set_vertex_order(static_cast<int32_t>(in.vertex_order));
+		data.mutable_settings()->set_query_threads(in.query_threads);
+	}
+	if (router_->router_) { // router internal data
+		const auto& in = router_->router_->routes_internal_data_;
+		auto& out = *data.mutable_routes_internal_data();
+		out.set_vertex_count(in.vertex_count);
+		out.mutable_weights()->Add(in.weights.begin(), in.weights.end());
+		out.mutable_prev_edges()->Add(in.prev_edges.begin(), in.prev_edges.end());
+	}
+	if (router_->ch_router_) { // contraction hierarchy overlay
+		*data.mutable_contraction_hierarchy() = move(SerializeContractionHierarchy());
+	}
+	if (router_->hub_router_) { // hub labels
+		*data.mutable_hub_labels() = move(SerializeHubLabels());
 	}
 	{ // stop to vertex id index
 		const auto& in = router_->stop_to_vertex_id_;
-		for (auto& stop_to_vertex : in) {
-			uint64_t id = stop_name_to_id_.at(stop_to_vertex.first->name);
+		for (uint64_t id = 0; id < in.size(); ++id) {
 			pbf_db::VertexPair vertex_pair_pbf;
-			vertex_pair_pbf.set_vertex1(move(stop_to_vertex.second.first));
-			vertex_pair_pbf.set_vertex2(move(stop_to_vertex.second.second));
+			vertex_pair_pbf.set_vertex1(in[id].first);
+			vertex_pair_pbf.set_vertex2(in[id].second);
 			(*data.mutable_stop_to_vertex_id())[id] = move(vertex_pair_pbf);
 		}
 	}
+	{ // vertex to stop index
+		const auto& vertex_to_stop = router_->vertex_to_stop_;
+		data.mutable_vertex_to_stop()->Add(vertex_to_stop.begin(), vertex_to_stop.end());
+		const auto& permutation = router_->vertex_permutation_;
+		data.mutable_vertex_permutation()->Add(permutation.begin(), permutation.end());
+	}
 	{ // edge id to item index
-		const auto& in = router_->edge_id_to_item_;
-		for (auto& edge_id_to_item : in) {
-			auto edge_id = edge_id_to_item.first;
-			pbf_db::RouteItem item_pbf;
-			visit(RouteItemVisiter{ item_pbf }, move(edge_id_to_item.second));
-			(*data.mutable_edge_id_to_item())[edge_id] = move(item_pbf);
+		auto& out = *data.mutable_edge_items();
+		for (const auto& item : router_->edge_items_) {
+			out.add_types(static_cast<uint32_t>(item.type));
+			out.add_indexes(item.index);
+			out.add_span_counts(item.span_count);
+			out.add_times(item.time);
 		}
 	}
 
@@ -327,57 +349,141 @@ void Protobuffer::DeserializeRouter(pbf_db::Router table) {
 		auto& out = router_->settings_;
 		out.bus_wait_time = table.settings().bus_wait_time();
 		out.bus_velocity = table.settings().bus_velocity();
+		out.router_type = static_cast<router::enRouterType>(table.settings().router_type());
+		out.route_cache_size = table.settings().route_cache_size();
+		out.route_rows_limit = table.settings().route_rows_limit();
+		out.graph_model = static_cast<router::enGraphModel>(table.settings().graph_model());
+		out.vertex_order = static_cast<router::enVertexOrder>(table.settings().vertex_order());
+		out.query_threads = table.settings().query_threads();
 		*router_settings_ = router_->settings_;
+		router_->InitRouteCache();
+		router_->InitSearchRouter();
 	}
-	{
-		auto& out = *router_->router_;
-		for (const auto& edges_pbf : table.edges()) {
-			vector<optional<graph::Router<double>::RouteInternalData>> edges;
-			for (const auto& edge_pbf : edges_pbf.edge()) {
-				optional<graph::Router<double>::RouteInternalData> edge;
-				if (edge_pbf.has_route_internal_data()) {
-					graph::Router<double>::RouteInternalData tmp;
-					tmp.weight = edge_pbf.route_internal_data().weight();
-					if (edge_pbf.route_internal_data().has_prev_edge()) {
-						tmp.prev_edge = edge_pbf.route_internal_data().prev_edge().value();
-					}
-					edge = move(tmp);
-				}
-				edges.push_back(move(edge));
-			}
-			out.routes_internal_data_.push_back(move(edges));
-		}
+	if (router_->settings_.router_type == router::enRouterType::CONTRACTION_HIERARCHIES) {
+		router_->router_.reset();
+		DeserializeContractionHierarchy(move(*table.mutable_contraction_hierarchy()));
+	}
+	else if (router_->settings_.router_type == router::enRouterType::HUB_LABELS) {
+		router_->router_.reset();
+		DeserializeHubLabels(move(*table.mutable_hub_labels()));
+	}
+	else if (router_->settings_.router_type != router::enRouterType::ALL_PAIRS) {
+		router_->InitRouterEngine();
+	}
+	else {
+		const auto& in = table.routes_internal_data();
+		auto& out = router_->router_->routes_internal_data_;
+		out.vertex_count = in.vertex_count();
+		out.weights.assign(in.weights().begin(), in.weights().end());
+		out.prev_edges.assign(in.prev_edges().begin(), in.prev_edges().end());
 	}
 	{ // stop to vertex id index
 		auto& out = router_->stop_to_vertex_id_;
+		out.resize(table.stop_to_vertex_id_size());
 		for (auto& stop_to_vertex_pbf : table.stop_to_vertex_id()) {
-			string stop_name = id_to_stop_name_.at(stop_to_vertex_pbf.first);
-			const Stop* stop = db_.stopname_to_stop_.at(stop_name);
-			std::pair<graph::VertexId, graph::VertexId> vertex_pair;
-			vertex_pair.first = move(stop_to_vertex_pbf.second.vertex1());
-			vertex_pair.second = move(stop_to_vertex_pbf.second.vertex2());
-			out[stop] = move(vertex_pair);
+			auto& vertex_pair = out.at(stop_to_vertex_pbf.first);
+			vertex_pair.first = stop_to_vertex_pbf.second.vertex1();
+			vertex_pair.second = stop_to_vertex_pbf.second.vertex2();
 		}
 	}
+	{ // vertex to stop index
+		auto& out = router_->vertex_to_stop_;
+		out.assign(table.vertex_to_stop().begin(), table.vertex_to_stop().end());
+		router_->vertex_permutation_.assign(table.vertex_permutation().begin(), table.vertex_permutation().end());
+	}
 	{ // edge id to item index
-		auto& out = router_->edge_id_to_item_;
-		for (auto& edge_id_to_item_pbf : table.edge_id_to_item()) {
-			size_t edge_id = edge_id_to_item_pbf.first;
-			if (edge_id_to_item_pbf.second.has_bus()) {
-				router::BusItem bus;
-				bus.bus_name = move(edge_id_to_item_pbf.second.bus().bus_name());
-				bus.span_count = move(edge_id_to_item_pbf.second.bus().span_count());
-				bus.time = move(edge_id_to_item_pbf.second.bus().time());
-				out[edge_id] = move(bus);
-			}
-			else if (edge_id_to_item_pbf.second.has_wait()) {
-				router::WaitItem wait;
-				wait.stop_name = move(edge_id_to_item_pbf.second.wait().stop_name());
-				wait.time = move(edge_id_to_item_pbf.second.wait().time());
-				out[edge_id] = move(wait);
-			}
+		const auto& in = table.edge_items();
+		auto& out = router_->edge_items_;
+		out.resize(in.types_size());
+		for (int i = 0; i < in.types_size(); ++i) {
+			out[i].type = static_cast<router::enEdgeItemType>(in.types(i));
+			out[i].index = in.indexes(i);
+			out[i].span_count = in.span_counts(i);
+			out[i].time = in.times(i);
 		}
 	}
 }
 
-} // ptb
\ No newline at end of file
+pbf_db::ContractionHierarchy Protobuffer::SerializeContractionHierarchy() {
+	pbf_db::ContractionHierarchy out;
+	const auto& in = router_->ch_router_->overlay_;
+
+	auto serialize_arcs = [](const auto& offsets, const auto& arcs, pbf_db::HierarchyArcs& arcs_pbf) {
+		arcs_pbf.mutable_offsets()->Add(offsets.begin(), offsets.end());
+		for (const auto& arc : arcs) {
+			arcs_pbf.add_to(arc.to);
+			arcs_pbf.add_weights(arc.weight);
+			arcs_pbf.add_ids(arc.id);
+		}
+	};
+
+	out.set_edge_count(in.edge_count);
+	serialize_arcs(in.up_offsets, in.up_arcs, *out.mutable_up());
+	serialize_arcs(in.down_offsets, in.down_arcs, *out.mutable_down());
+	for (const auto& shortcut : in.shortcuts) {
+		out.add_shortcut_first(shortcut.first);
+		out.add_shortcut_second(shortcut.second);
+	}
+
+	return out;
+}
+
+void Protobuffer::DeserializeContractionHierarchy(pbf_db::ContractionHierarchy in) {
+	using ChRouter = graph::ContractionHierarchyRouter<double>;
+	ChRouter::Overlay out;
+
+	auto deserialize_arcs = [](const pbf_db::HierarchyArcs& arcs_pbf,
+							   vector<size_t>& offsets, vector<ChRouter::Arc>& arcs) {
+		offsets.assign(arcs_pbf.offsets().begin(), arcs_pbf.offsets().end());
+		arcs.reserve(arcs_pbf.to_size());
+		for (int i = 0; i < arcs_pbf.to_size(); ++i) {
+			arcs.push_back({ arcs_pbf.to(i), arcs_pbf.weights(i), arcs_pbf.ids(i) });
+		}
+	};
+
+	out.edge_count = in.edge_count();
+	deserialize_arcs(in.up(), out.up_offsets, out.up_arcs);
+	deserialize_arcs(in.down(), out.down_offsets, out.down_arcs);
+	out.shortcuts.reserve(in.shortcut_first_size());
+	for (int i = 0; i < in.shortcut_first_size(); ++i) {
+		out.shortcuts.push_back({ in.shortcut_first(i), in.shortcut_second(i) });
+	}
+
+	router_->ch_router_ = make_unique<ChRouter>(*router_->graph_, move(out));
+}
+
+pbf_db::HubLabels Protobuffer::SerializeHubLabels() {
+	pbf_db::HubLabels out;
+	const auto& in = router_->hub_router_->index_;
+
+	auto serialize_labels = [](const auto& labels, pbf_db::HubLabelArrays& labels_pbf) {
+		labels_pbf.mutable_offsets()->Add(labels.offsets.begin(), labels.offsets.end());
+		labels_pbf.mutable_hubs()->Add(labels.hubs.begin(), labels.hubs.end());
+		labels_pbf.mutable_weights()->Add(labels.weights.begin(), labels.weights.end());
+		labels_pbf.mutable_edges()->Add(labels.edges.begin(), labels.edges.end());
+	};
+
+	serialize_labels(in.out_labels, *out.mutable_out_labels());
+	serialize_labels(in.in_labels, *out.mutable_in_labels());
+
+	return out;
+}
+
+void Protobuffer::DeserializeHubLabels(pbf_db::HubLabels in) {
+	using HubRouter = graph::HubLabelRouter<double>;
+	HubRouter::Index out;
+
+	auto deserialize_labels = [](const pbf_db::HubLabelArrays& labels_pbf, HubRouter::Labels& labels) {
+		labels.offsets.assign(labels_pbf.offsets().begin(), labels_pbf.offsets().end());
+		labels.hubs.assign(labels_pbf.hubs().begin(), labels_pbf.hubs().end());
+		labels.weights.assign(labels_pbf.weights().begin(), labels_pbf.weights().end());
+		labels.edges.assign(labels_pbf.edges().begin(), labels_pbf.edges().end());
+	};
+
+	deserialize_labels(in.out_labels(), out.out_labels);
+	deserialize_labels(in.in_labels(), out.in_labels);
+
+	router_->hub_router_ = make_unique<HubRouter>(*router_->graph_, move(out));
+}
+
+} // ptb
@@ -18,6 +18,7 @@
 #include <variant>
 #include <optional>
 #include <map>
+#include <memory>
 
 namespace ptb {
 
@@ -30,7 +31,6 @@ public:
     Protobuffer(transport_db::TransportCatalogue& db)
         : db_(db)
     {
-        StopsIdInit();
     }
 
     Protobuffer(transport_db::TransportCatalogue& db,
@@ -42,11 +42,11 @@ public:
         , router_settings_(router_settings)
         , router_(router)
     {
-        StopsIdInit();
     }
 
     void SerializeDB(std::string filename);
-    void DeserializeDB(std::string filename);
+    // Возвращает маршрутизатор, если база создана с настройками маршрутизации, иначе nullptr
+    std::unique_ptr<router::TransportRouter> DeserializeDB(std::string filename);
 
 private:
 	transport_db::TransportCatalogue& db_;
@@ -55,9 +55,6 @@ private:
     router::RoutingSettings* router_settings_;
     router::TransportRouter* router_;
 
-    std::map<std::string, uint64_t> stop_name_to_id_;
-    std::map<uint64_t, std::string> id_to_stop_name_;
-
     pbf_db::RenderSettings SerializeRenderSettings();
     void DeserializeRenderSettings(pbf_db::RenderSettings in);
 
@@ -67,14 +64,11 @@ private:
     pbf_db::Router SerializeRouter();
     void DeserializeRouter(pbf_db::Router table);
 
-    void StopsIdInit() {
-        const std::deque<Stop>& stops = db_.stops_;
-        uint64_t i = 0;
-        for (const Stop& stop : stops) {
-            stop_name_to_id_[stop.name] = i;
-            ++i;
-        }
-    }
+    pbf_db::ContractionHierarchy SerializeContractionHierarchy();
+    void DeserializeContractionHierarchy(pbf_db::ContractionHierarchy in);
+
+    pbf_db::HubLabels SerializeHubLabels();
+    void DeserializeHubLabels(pbf_db::HubLabels in);
 };
 
 struct ColorSerializePrinter {
@@ -126,24 +120,4 @@ struct ColorDeserializePrinter {
     }
 };
 
-struct RouteItemVisiter {
-    pbf_db::RouteItem& item_pbf;
-
-    void operator()(std::monostate) const {
-    }
-    void operator()(const router::WaitItem& wait) {
-        pbf_db::WaitItem wait_pbf;
-        wait_pbf.set_stop_name(std::string(wait.stop_name));
-        wait_pbf.set_time(wait.time);
-        *item_pbf.mutable_wait() = wait_pbf;
-    }
-    void operator()(const router::BusItem& bus) {
-        pbf_db::BusItem bus_pbf;
-        bus_pbf.set_bus_name(std::string(bus.bus_name));
-        bus_pbf.set_span_count(bus.span_count);
-        bus_pbf.set_time(bus.time);
-        *item_pbf.mutable_bus() = bus_pbf;
-    }
-};
-
 }
\ No newline at end of file
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "domain.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace transport_db {
+
+// Расстояния по дорогам между парами остановок: открытая адресация с линейным пробированием
+// по ключу (from << 32 | to). Вместе с заданным расстоянием хранится и обратное к нему,
+// пока для обратной пары не задано своё, поэтому поиск с запасным направлением - одна проба
+class SpansMap {
+public:
+    void Set(StopId from, StopId to, int distance) {
+        Insert(PackKey(from, to), distance, true);
+        Insert(PackKey(to, from), distance, false);
+    }
+
+    // расстояние from -> to, а если оно не задано - to -> from
+    std::optional<int> Find(StopId from, StopId to) const {
+        if (entries_.empty()) {
+            return std::nullopt;
+        }
+        const uint64_t key = PackKey(from, to);
+        for (size_t i = Slot(key);; i = (i + 1) & mask_) {
+            if (entries_[i].key == key) {
+                return entries_[i].distance;
+            }
+            if (entries_[i].key == EMPTY_KEY) {
+                return std::nullopt;
+            }
+        }
+    }
+
+    // обходит только заданные расстояния, без обратных к ним
+    template <typename Func>
+    void ForEach(Func func) const {
+        for (const Entry& entry : entries_) {
+            if (entry.key != EMPTY_KEY && entry.is_direct) {
+                func(static_cast<StopId>(entry.key >> 32), static_cast<StopId>(entry.key), entry.distance);
+            }
+        }
+    }
+
+private:
+    static constexpr uint64_t EMPTY_KEY = ~uint64_t{ 0 };
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    struct Entry {
+        uint64_t key = EMPTY_KEY;
+        int distance = 0;
+        bool is_direct = false;
+    };
+
+    std::vector<Entry> entries_;
+    size_t mask_ = 0;
+    // 64 - log2 ёмкости: номер ячейки - старшие биты произведения
+    unsigned shift_ = 64;
+    size_t size_ = 0;
+
+    static uint64_t PackKey(StopId from, StopId to) {
+        return (static_cast<uint64_t>(from) << 32) | to;
+    }
+
+    // фибоначчиево хеширование: хорошо перемешаны только старшие биты произведения,
+    // поэтому номер ячейки берётся из них, и соседние пары остановок не слипаются в цепочки
+    size_t Slot(uint64_t key) const {
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> shift_);
+    }
+
+    void Insert(uint64_t key, int distance, bool is_direct) {
+        // заполненность не больше половины, чтобы цепочки проб оставались короткими
+        if ((size_ + 1) * 2 > entries_.size()) {
+            Rehash(std::max(entries_.size() * 2, MIN_CAPACITY));
+        }
+        size_t i = Slot(key);
+        for (; entries_[i].key != EMPTY_KEY; i = (i + 1) & mask_) {
+            if (entries_[i].key == key) {
+                // обратное расстояние не затирает заданное явно
+                if (is_direct || !entries_[i].is_direct) {
+                    entries_[i].distance = distance;
+                    entries_[i].is_direct = is_direct;
+                }
+                return;
+            }
+        }
+        entries_[i] = { key, distance, is_direct };
+        ++size_;
+    }
+
+    void Rehash(size_t capacity) {
+        std::vector<Entry> old_entries(capacity);
+        std::swap(entries_, old_entries);
+        mask_ = capacity - 1;
+        shift_ = 64;
+        for (size_t i = capacity; i > 1; i >>= 1) {
+            --shift_;
+        }
+        for (const Entry& entry : old_entries) {
+            if (entry.key != EMPTY_KEY) {
+                size_t i = Slot(entry.key);
+                while (entries_[i].key != EMPTY_KEY) {
+                    i = (i + 1) & mask_;
+                }
+                entries_[i] = entry;
+            }
+        }
+    }
+};
+
+}
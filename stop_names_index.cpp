@@ -0,0 +1,181 @@
+#include "stop_names_index.h"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace std;
+
+namespace transport_db {
+
+// Узлы добавляются в ширину, поэтому дети каждого узла идут подряд. Остановки узла
+// упорядочены, и общее начало всех их имён - общее начало первого и последнего
+void StopNamesIndex::Build(const vector<Stop>& stops) {
+	vector<u32string> folded(stops.size());
+	for (const Stop& stop : stops) {
+		folded[stop.id] = Fold(stop.name);
+	}
+	stops_.resize(stops.size());
+	iota(stops_.begin(), stops_.end(), StopId{ 0 });
+	sort(stops_.begin(), stops_.end(), [&folded](StopId lhs, StopId rhs) {
+		return pair{ folded[lhs], lhs } < pair{ folded[rhs], rhs };
+	});
+	folded_names_.clear();
+	folded_names_.reserve(stops_.size());
+	for (StopId stop : stops_) {
+		folded_names_.push_back(move(folded[stop]));
+	}
+
+	nodes_.clear();
+	nodes_.push_back({ 0, 0, 0, 0, static_cast<uint32_t>(stops_.size()) });
+	for (size_t i = 0; i < nodes_.size(); ++i) {
+		const uint32_t depth = nodes_[i].depth;
+		uint32_t begin = nodes_[i].stops_begin;
+		const uint32_t end = nodes_[i].stops_end;
+		// имена, которые заканчиваются в узле, стоят в его отрезке первыми
+		while (begin < end && folded_names_[begin].size() == depth) {
+			++begin;
+		}
+		nodes_[i].children_begin = static_cast<uint32_t>(nodes_.size());
+		while (begin < end) {
+			const char32_t letter = folded_names_[begin][depth];
+			uint32_t group_end = begin + 1;
+			while (group_end < end && folded_names_[group_end][depth] == letter) {
+				++group_end;
+			}
+			const u32string& first = folded_names_[begin];
+			const u32string& last = folded_names_[group_end - 1];
+			const auto common_end = mismatch(first.begin() + depth, first.end(), last.begin() + depth, last.end());
+			const uint32_t child_depth = static_cast<uint32_t>(common_end.first - first.begin());
+			nodes_.push_back({ child_depth, 0, 0, begin, group_end });
+			begin = group_end;
+		}
+		nodes_[i].children_end = static_cast<uint32_t>(nodes_.size());
+	}
+}
+
+bool StopNamesIndex::IsBuilt(const vector<Stop>& stops) const {
+	return !nodes_.empty() && stops_.size() == stops.size();
+}
+
+vector<StopMatch> StopNamesIndex::Find(const vector<Stop>& stops,
+	string_view query, size_t count, size_t max_edits) const {
+	vector<StopMatch> result;
+	if (count == 0 || nodes_.empty()) {
+		return result;
+	}
+	const u32string folded_query = Fold(query);
+	// с числом правок, равным длине запроса, подходит любое имя
+	max_edits = min(max_edits, folded_query.size());
+
+	// строка таблицы расстояний Левенштейна между началами запроса и пустым префиксом
+	vector<size_t> row(folded_query.size() + 1);
+	iota(row.begin(), row.end(), size_t{ 0 });
+	vector<Match> matches;
+	size_t best_edits = max_edits + 1;
+	if (row.back() <= max_edits) {
+		best_edits = row.back();
+		matches.push_back({ nodes_[0].stops_begin, nodes_[0].stops_end, best_edits });
+	}
+	Search(nodes_[0], folded_query, row, best_edits, matches);
+
+	// отрезки с одинаковым числом правок не пересекаются, отрезок с меньшим числом правок
+	// может лежать внутри отрезка с большим - его остановки уже выданы и отмечены
+	sort(matches.begin(), matches.end(), [](const Match& lhs, const Match& rhs) {
+		return pair{ lhs.edits, lhs.stops_begin } < pair{ rhs.edits, rhs.stops_begin };
+	});
+	vector<bool> is_found(stops_.size());
+	for (const Match& match : matches) {
+		for (uint32_t i = match.stops_begin; i < match.stops_end && result.size() < count; ++i) {
+			if (!is_found[i]) {
+				is_found[i] = true;
+				result.push_back({ &stops[stops_[i]], match.edits });
+			}
+		}
+		if (result.size() == count) {
+			break;
+		}
+	}
+	return result;
+}
+
+// Дерево обходится в глубину с добавлением строки таблицы Левенштейна на каждую букву.
+// Поддерево отбрасывается, когда минимум строки не меньше лучшего числа правок на пути:
+// дальше расстояние только растёт
+void StopNamesIndex::Search(const Node& node, const u32string& query, const vector<size_t>& row,
+	size_t best_edits, vector<Match>& matches) const {
+	vector<size_t> child_row;
+	for (uint32_t child_index = node.children_begin; child_index < node.children_end; ++child_index) {
+		const Node& child = nodes_[child_index];
+		const u32string& name = folded_names_[child.stops_begin];
+		child_row = row;
+		size_t child_best = best_edits;
+		bool is_pruned = false;
+		for (uint32_t depth = node.depth; depth < child.depth && !is_pruned; ++depth) {
+			size_t diagonal = child_row[0];
+			++child_row[0];
+			size_t row_min = child_row[0];
+			for (size_t j = 1; j < child_row.size(); ++j) {
+				const size_t replace = diagonal + (query[j - 1] != name[depth] ? 1 : 0);
+				diagonal = child_row[j];
+				child_row[j] = min({ child_row[j] + 1, child_row[j - 1] + 1, replace });
+				row_min = min(row_min, child_row[j]);
+			}
+			if (child_row.back() < child_best) {
+				child_best = child_row.back();
+				matches.push_back({ child.stops_begin, child.stops_end, child_best });
+			}
+			is_pruned = row_min >= child_best;
+		}
+		if (!is_pruned) {
+			Search(child, query, child_row, child_best, matches);
+		}
+	}
+}
+
+u32string StopNamesIndex::Fold(string_view name) {
+	u32string folded;
+	folded.reserve(name.size());
+	for (size_t i = 0; i < name.size();) {
+		const auto byte = static_cast<unsigned char>(name[i]);
+		// длина символа по первому байту; обрывки UTF-8 берутся побайтно
+		size_t length = byte < 0x80 ? 1 : (byte >> 5) == 0x6 ? 2 : (byte >> 4) == 0xE ? 3 : (byte >> 3) == 0x1E ? 4 : 0;
+		char32_t letter = length == 1 ? byte : length == 2 ? byte & 0x1F : length == 3 ? byte & 0x0F : byte & 0x07;
+		for (size_t k = 1; k < length; ++k) {
+			const auto next = i + k < name.size() ? static_cast<unsigned char>(name[i + k]) : 0;
+			if ((next >> 6) != 0x2) {
+				length = 0;
+				break;
+			}
+			letter = (letter << 6) | (next & 0x3F);
+		}
+		if (length == 0) {
+			letter = byte;
+			length = 1;
+		}
+		i += length;
+
+		if (letter >= U'A' && letter <= U'Z') {
+			letter += U'a' - U'A';
+		}
+		else if (letter >= 0x0410 && letter <= 0x042F) {
+			// А-Я
+			letter += 0x0020;
+		}
+		else if (letter == 0x0401 || letter == 0x0451) {
+			// Ё, ё -> е
+			letter = 0x0435;
+		}
+		folded.push_back(letter);
+	}
+	return folded;
+}
+
+void StopNamesIndex::ComputeFoldedNames(const vector<Stop>& stops) {
+	folded_names_.clear();
+	folded_names_.reserve(stops_.size());
+	for (StopId stop : stops_) {
+		folded_names_.push_back(Fold(stops[stop].name));
+	}
+}
+
+}
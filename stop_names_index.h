@@ -0,0 +1,59 @@
+#pragma once
+
+#include "domain.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ptb {
+    class Protobuffer;
+}
+
+namespace transport_db {
+
+// Поиск остановок по началу имени, в том числе с опечатками. Сжатое префиксное дерево
+// над именами, приведёнными к нижнему регистру: узлы и остановки лежат в массивах,
+// остановки - по алфавиту, поэтому остановки поддерева узла - отрезок массива
+class StopNamesIndex {
+    friend ptb::Protobuffer;
+public:
+    void Build(const std::vector<Stop>& stops);
+    bool IsBuilt(const std::vector<Stop>& stops) const;
+
+    // count остановок, начало имени которых отличается от query не больше чем на max_edits
+    // правок (вставка, удаление, замена буквы): сначала с меньшим числом правок, затем по имени
+    std::vector<StopMatch> Find(const std::vector<Stop>& stops,
+        std::string_view query, size_t count, size_t max_edits) const;
+
+private:
+    // метка ребра в узел - буквы имени первой остановки узла от глубины родителя до depth
+    struct Node {
+        uint32_t depth = 0;
+        uint32_t children_begin = 0;
+        uint32_t children_end = 0;
+        uint32_t stops_begin = 0;
+        uint32_t stops_end = 0;
+    };
+
+    // отрезок остановок, начало имён которых отличается от запроса на edits правок
+    struct Match {
+        uint32_t stops_begin = 0;
+        uint32_t stops_end = 0;
+        size_t edits = 0;
+    };
+
+    // буквы UTF-8 в нижнем регистре (латиница и кириллица), ё не отличается от е
+    static std::u32string Fold(std::string_view name);
+    void ComputeFoldedNames(const std::vector<Stop>& stops);
+    void Search(const Node& node, const std::u32string& query, const std::vector<size_t>& row,
+        size_t best_edits, std::vector<Match>& matches) const;
+
+    std::vector<Node> nodes_;
+    std::vector<StopId> stops_;
+    // имена остановок в порядке stops_, в базе не хранятся
+    std::vector<std::u32string> folded_names_;
+};
+
+}
@@ -0,0 +1,182 @@
+#define _USE_MATH_DEFINES
+#include "stops_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <queue>
+
+using namespace std;
+
+namespace transport_db {
+
+namespace {
+
+// тот же радиус Земли, что и в geo::ComputeDistance
+const double EARTH_RADIUS = 6371000;
+
+double ChordToDistance(double chord_sq) {
+	return 2 * EARTH_RADIUS * asin(min(sqrt(chord_sq) / 2, 1.));
+}
+
+}
+
+void StopsIndex::Build(const vector<Stop>& stops) {
+	ComputePoints(stops);
+	tree_.resize(stops.size());
+	iota(tree_.begin(), tree_.end(), StopId{ 0 });
+	axes_.assign(stops.size(), 0);
+	BuildSubtree(0, tree_.size());
+}
+
+bool StopsIndex::IsBuilt(const vector<Stop>& stops) const {
+	return tree_.size() == stops.size() && axes_.size() == stops.size();
+}
+
+vector<NearbyStop> StopsIndex::FindNearest(const vector<Stop>& stops,
+	geo::Coordinates coord, size_t count) const {
+	// в куче - найденные ближайшие, сверху самая дальняя из них
+	struct NearestVisitor {
+		size_t count;
+		priority_queue<pair<double, StopId>> nearest;
+
+		double Bound() const {
+			return nearest.size() < count ? numeric_limits<double>::infinity() : nearest.top().first;
+		}
+		void Visit(StopId stop, double chord_sq) {
+			if (nearest.size() < count) {
+				nearest.push({ chord_sq, stop });
+			}
+			else if (pair{ chord_sq, stop } < nearest.top()) {
+				nearest.pop();
+				nearest.push({ chord_sq, stop });
+			}
+		}
+	};
+
+	vector<NearbyStop> result;
+	if (count == 0 || tree_.empty()) {
+		return result;
+	}
+	NearestVisitor visitor{ count, {} };
+	Search(ToPoint(coord), 0, tree_.size(), visitor);
+	result.resize(visitor.nearest.size());
+	for (auto it = result.rbegin(); it != result.rend(); ++it) {
+		const auto [chord_sq, stop] = visitor.nearest.top();
+		*it = { &stops[stop], ChordToDistance(chord_sq) };
+		visitor.nearest.pop();
+	}
+	return result;
+}
+
+vector<NearbyStop> StopsIndex::FindWithin(const vector<Stop>& stops,
+	geo::Coordinates coord, double radius) const {
+	struct WithinVisitor {
+		double bound;
+		vector<pair<double, StopId>> found;
+
+		double Bound() const {
+			return bound;
+		}
+		void Visit(StopId stop, double chord_sq) {
+			if (chord_sq <= bound) {
+				found.push_back({ chord_sq, stop });
+			}
+		}
+	};
+
+	vector<NearbyStop> result;
+	if (radius < 0 || tree_.empty()) {
+		return result;
+	}
+	// радиус в метрах переводится в хорду; дальше половины окружности - вся сфера
+	const double chord = radius < M_PI * EARTH_RADIUS ? 2 * sin(radius / (2 * EARTH_RADIUS)) : 2.;
+	WithinVisitor visitor{ chord * chord, {} };
+	Search(ToPoint(coord), 0, tree_.size(), visitor);
+	sort(visitor.found.begin(), visitor.found.end());
+	result.reserve(visitor.found.size());
+	for (const auto& [chord_sq, stop] : visitor.found) {
+		result.push_back({ &stops[stop], ChordToDistance(chord_sq) });
+	}
+	return result;
+}
+
+StopsIndex::Point StopsIndex::ToPoint(geo::Coordinates coord) {
+	static const double dr = M_PI / 180.;
+	const double lat = coord.lat * dr;
+	const double lng = coord.lng * dr;
+	return { cos(lat) * cos(lng), cos(lat) * sin(lng), sin(lat) };
+}
+
+void StopsIndex::ComputePoints(const vector<Stop>& stops) {
+	points_.clear();
+	points_.reserve(stops.size());
+	for (const Stop& stop : stops) {
+		points_.push_back(ToPoint(stop.coord));
+	}
+}
+
+// ось разбиения - та, по которой точки поддерева разбросаны сильнее: остановки города
+// занимают на сфере маленький участок, и одна из осей почти не меняется
+void StopsIndex::BuildSubtree(size_t begin, size_t end) {
+	if (end - begin <= 1) {
+		return;
+	}
+	Point min_point = points_[tree_[begin]];
+	Point max_point = min_point;
+	for (size_t i = begin + 1; i < end; ++i) {
+		for (size_t axis = 0; axis < 3; ++axis) {
+			min_point[axis] = min(min_point[axis], points_[tree_[i]][axis]);
+			max_point[axis] = max(max_point[axis], points_[tree_[i]][axis]);
+		}
+	}
+	uint8_t axis = 0;
+	for (uint8_t a = 1; a < 3; ++a) {
+		if (max_point[a] - min_point[a] > max_point[axis] - min_point[axis]) {
+			axis = a;
+		}
+	}
+
+	const size_t mid = begin + (end - begin) / 2;
+	nth_element(tree_.begin() + begin, tree_.begin() + mid, tree_.begin() + end,
+		[this, axis](StopId lhs, StopId rhs) {
+			return pair{ points_[lhs][axis], lhs } < pair{ points_[rhs][axis], rhs };
+		});
+	axes_[mid] = axis;
+	BuildSubtree(begin, mid);
+	BuildSubtree(mid + 1, end);
+}
+
+// Сначала обходится половина, в которой лежит точка, затем другая - если плоскость
+// разбиения ближе самой дальней из нужных остановок
+template <typename Visitor>
+void StopsIndex::Search(const Point& point, size_t begin, size_t end, Visitor& visitor) const {
+	if (begin >= end) {
+		return;
+	}
+	const size_t mid = begin + (end - begin) / 2;
+	const StopId stop = tree_[mid];
+	const Point& stop_point = points_[stop];
+	double chord_sq = 0;
+	for (size_t axis = 0; axis < 3; ++axis) {
+		chord_sq += (point[axis] - stop_point[axis]) * (point[axis] - stop_point[axis]);
+	}
+	visitor.Visit(stop, chord_sq);
+
+	const double diff = point[axes_[mid]] - stop_point[axes_[mid]];
+	if (diff < 0) {
+		Search(point, begin, mid, visitor);
+		if (diff * diff <= visitor.Bound()) {
+			Search(point, mid + 1, end, visitor);
+		}
+	}
+	else {
+		Search(point, mid + 1, end, visitor);
+		if (diff * diff <= visitor.Bound()) {
+			Search(point, begin, mid, visitor);
+		}
+	}
+}
+
+}
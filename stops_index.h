@@ -0,0 +1,50 @@
+#pragma once
+
+#include "domain.h"
+#include "geo.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace ptb {
+    class Protobuffer;
+}
+
+namespace transport_db {
+
+// Пространственный индекс остановок: k-d дерево по точкам на единичной сфере.
+// Хорда между точками растёт вместе с расстоянием по поверхности, поэтому разность
+// координат по оси разбиения - нижняя граница расстояния до всей другой половины дерева.
+// Дерево неявное: корень поддерева [begin, end) лежит в его середине
+class StopsIndex {
+    friend ptb::Protobuffer;
+public:
+    void Build(const std::vector<Stop>& stops);
+    bool IsBuilt(const std::vector<Stop>& stops) const;
+
+    // count ближайших к точке остановок по возрастанию расстояния
+    std::vector<NearbyStop> FindNearest(const std::vector<Stop>& stops,
+        geo::Coordinates coord, size_t count) const;
+    // остановки не дальше radius метров от точки по возрастанию расстояния
+    std::vector<NearbyStop> FindWithin(const std::vector<Stop>& stops,
+        geo::Coordinates coord, double radius) const;
+
+private:
+    using Point = std::array<double, 3>;
+
+    static Point ToPoint(geo::Coordinates coord);
+    void ComputePoints(const std::vector<Stop>& stops);
+    void BuildSubtree(size_t begin, size_t end);
+
+    template <typename Visitor>
+    void Search(const Point& point, size_t begin, size_t end, Visitor& visitor) const;
+
+    // номера остановок в порядке неявного дерева и ось разбиения в каждом узле
+    std::vector<StopId> tree_;
+    std::vector<uint8_t> axes_;
+    // точки остановок по номеру остановки, в базе не хранятся
+    std::vector<Point> points_;
+};
+
+}
@@ -0,0 +1,136 @@
+// Проверки входных данных при создании и обновлении базы: повторы имён, расстояния и автобусы
+// через неизвестные остановки, остановки справочника без вершин в маршрутизаторе
+#include "request_handler.h"
+#include "transport_router.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+bool is_ok = true;
+
+void Check(bool condition, const string& what) {
+	if (!condition) {
+		cerr << "FAILED: " << what << endl;
+		is_ok = false;
+	}
+}
+
+template <typename Exception, typename Func>
+void CheckThrows(Func func, const string& what) {
+	try {
+		func();
+	}
+	catch (const Exception&) {
+		return;
+	}
+	catch (...) {
+	}
+	Check(false, what);
+}
+
+router::RoutingSettings MakeSettings() {
+	router::RoutingSettings settings;
+	settings.bus_wait_time = 2;
+	settings.bus_velocity = 30;
+	settings.router_type = router::enRouterType::DIJKSTRA;
+	return settings;
+}
+
+// база из остановок A, B и автобуса 1
+void FillBase(in::RequestHandler& handler) {
+	handler.AddRoutingSettings(MakeSettings());
+	handler.AddStopRequest({ "A", { 43.0, 39.0 }, { { "B", 1000 } } });
+	handler.AddStopRequest({ "B", { 43.01, 39.0 }, {} });
+	handler.AddBusRequest({ "1", { "A", "B" }, false });
+	handler.ProcessBaseCreateRequests();
+}
+
+void TestCatalogueDuplicates() {
+	transport_db::TransportCatalogue db;
+	const StopId a = db.AddStop("A", { 43.0, 39.0 });
+	db.AddBus("1", { a }, false);
+	CheckThrows<invalid_argument>([&] { db.AddStop("A", { 43.1, 39.1 }); }, "duplicate stop");
+	CheckThrows<invalid_argument>([&] { db.AddBus("1", { a }, true); }, "duplicate bus");
+	Check(db.GetStops().size() == 1 && db.GetBuses().size() == 1, "duplicates are not added");
+}
+
+void TestUpdateRejected() {
+	struct Case {
+		string what;
+		vector<in::StopInfo> stops;
+		vector<in::BusRoute> buses;
+	};
+	const vector<Case> cases = {
+		{ "existing stop", { { "A", { 43.2, 39.0 }, {} } }, {} },
+		{ "stop repeated in update", { { "C", { 43.2, 39.0 }, {} }, { "C", { 43.3, 39.0 }, {} } }, {} },
+		{ "existing bus", {}, { { "1", { "A" }, true } } },
+		{ "bus repeated in update", {}, { { "2", { "A" }, true }, { "2", { "B" }, true } } },
+		{ "distance to unknown stop", { { "C", { 43.2, 39.0 }, { { "Nope", 500 } } } }, {} },
+		{ "bus through unknown stop", {}, { { "2", { "A", "Nope" }, false } } },
+	};
+	for (const auto& test_case : cases) {
+		transport_db::TransportCatalogue db;
+		in::RequestHandler handler(db);
+		FillBase(handler);
+		for (const auto& stop : test_case.stops) {
+			handler.AddStopRequest(stop);
+		}
+		for (const auto& bus : test_case.buses) {
+			handler.AddBusRequest(bus);
+		}
+		CheckThrows<invalid_argument>([&] { handler.ProcessBaseUpdateRequests(); }, test_case.what);
+		// отклонённое обновление не меняет справочник
+		Check(db.GetStops().size() == 2 && db.GetBuses().size() == 1, test_case.what + ": base is unchanged");
+	}
+}
+
+void TestUpdateAccepted() {
+	transport_db::TransportCatalogue db;
+	in::RequestHandler handler(db);
+	FillBase(handler);
+	// расстояние до остановки из того же обновления, автобус через старую и новую остановки
+	handler.AddStopRequest({ "C", { 43.02, 39.0 }, { { "B", 1500 } } });
+	handler.AddBusRequest({ "2", { "B", "C" }, false });
+	handler.ProcessBaseUpdateRequests();
+	Check(db.FindStop("C") != nullptr && db.FindBus("2") != nullptr, "update is applied");
+	Check(db.GetStopsDistance(db.FindStop("C")->id, db.FindStop("B")->id) == 1500, "distance to new stop");
+}
+
+void TestUnroutedStop() {
+	transport_db::TransportCatalogue db;
+	const StopId a = db.AddStop("A", { 43.0, 39.0 });
+	const StopId b = db.AddStop("B", { 43.01, 39.0 });
+	db.SetStopsDistance(a, b, 1000);
+	db.AddBus("1", { a, b }, false);
+	router::TransportRouter router(db, MakeSettings());
+	router.InitGraph();
+	router.InitRouter();
+
+	// остановка D добавлена в маршрутизатор раньше C: C остаётся без вершин, а не получает вершины A
+	db.AddStop("C", { 43.02, 39.0 });
+	const StopId d = db.AddStop("D", { 43.03, 39.0 });
+	router.AddStop(d);
+	router::RouteScratch scratch;
+	CheckThrows<out_of_range>([&] { router.GetOptimalRoute("C", "B", scratch); }, "route from unrouted stop");
+	const auto route = router.GetOptimalRoute("D", "D", scratch);
+	Check(route.has_value() && route->total_time == 0., "route within routed stop");
+	Check(!router.GetOptimalRoute("D", "B", scratch).has_value(), "no route from new stop");
+}
+
+}
+
+int main() {
+	TestCatalogueDuplicates();
+	TestUpdateRejected();
+	TestUpdateAccepted();
+	TestUnroutedStop();
+	if (is_ok) {
+		cout << "OK" << endl;
+	}
+	return is_ok ? 0 : 1;
+}
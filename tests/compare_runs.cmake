@@ -0,0 +1,42 @@
+# Создаёт базу по BASE_A и по BASE_B, отвечает на REQUESTS по каждой и сравнивает ответы.
+# Без BASE_B ответы по BASE_A только сравниваются с EXPECTED.
+# Если задан UPDATE_A или UPDATE_B, соответствующая база после создания дополняется им.
+# Если задан EXPECTED, ответы по BASE_A сравниваются и с ним.
+# Запуск: cmake -DWIMBUS=... -DBASE_A=... [-DBASE_B=...] -DREQUESTS=...
+#     [-DUPDATE_A=...] [-DUPDATE_B=...] [-DEXPECTED=...] -P compare_runs.cmake
+
+function(run_base base update output)
+    execute_process(COMMAND ${WIMBUS} make_base INPUT_FILE ${base} RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "make_base failed for ${base}: ${result}")
+    endif()
+    if(update)
+        execute_process(COMMAND ${WIMBUS} update_base INPUT_FILE ${update} RESULT_VARIABLE result)
+        if(NOT result EQUAL 0)
+            message(FATAL_ERROR "update_base failed for ${update}: ${result}")
+        endif()
+    endif()
+    execute_process(COMMAND ${WIMBUS} process_requests
+        INPUT_FILE ${REQUESTS} OUTPUT_FILE ${output} RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "process_requests failed for ${base}: ${result}")
+    endif()
+endfunction()
+
+run_base(${BASE_A} "${UPDATE_A}" output_a.json)
+file(READ output_a.json output_a)
+
+if(DEFINED BASE_B)
+    run_base(${BASE_B} "${UPDATE_B}" output_b.json)
+    file(READ output_b.json output_b)
+    if(NOT output_a STREQUAL output_b)
+        message(FATAL_ERROR "Responses differ: ${BASE_A} vs ${BASE_B}, see output_a.json and output_b.json")
+    endif()
+endif()
+
+if(DEFINED EXPECTED)
+    file(READ ${EXPECTED} expected)
+    if(NOT output_a STREQUAL expected)
+        message(FATAL_ERROR "Responses differ from ${EXPECTED}, see output_a.json")
+    endif()
+endif()
@@ -0,0 +1,113 @@
+// Списки смежности DirectedWeightedGraph в формате CSR сверяются с рёбрами графа: исходящие и входящие
+// рёбра каждой вершины в порядке добавления, петли, кратные рёбра, вершины без рёбер и достройка графа
+#include "graph.h"
+
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+bool is_ok = true;
+
+void Check(bool condition, const string& what) {
+	if (!condition) {
+		cerr << "FAILED: " << what << endl;
+		is_ok = false;
+	}
+}
+
+using Graph = graph::DirectedWeightedGraph<double>;
+using Record = tuple<graph::VertexId, double, graph::EdgeId>;
+
+// записи списков смежности, собранные прямым перебором рёбер
+void CheckLists(const Graph& graph, const string& what) {
+	for (graph::VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+		vector<Record> outgoing;
+		vector<Record> incoming;
+		for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+			const auto& edge = graph.GetEdge(edge_id);
+			if (edge.from == vertex) {
+				outgoing.emplace_back(edge.to, edge.weight, edge_id);
+			}
+			if (edge.to == vertex) {
+				incoming.emplace_back(edge.from, edge.weight, edge_id);
+			}
+		}
+		vector<Record> csr_outgoing;
+		for (const auto& edge : graph.GetIncidentEdges(vertex)) {
+			csr_outgoing.emplace_back(edge.to, edge.weight, edge.id);
+		}
+		vector<Record> csr_incoming;
+		for (const auto& edge : graph.GetIncomingEdges(vertex)) {
+			csr_incoming.emplace_back(edge.to, edge.weight, edge.id);
+		}
+		Check(csr_outgoing == outgoing, what + ": outgoing edges of vertex " + to_string(vertex));
+		Check(csr_incoming == incoming, what + ": incoming edges of vertex " + to_string(vertex));
+	}
+}
+
+void TestSmallGraph() {
+	Graph graph(4);
+	graph.AddEdge({ 0, 1, 1. });
+	graph.AddEdge({ 0, 1, 2. });
+	graph.AddEdge({ 2, 2, 3. });
+	graph.AddEdge({ 2, 0, 4. });
+	// у вершины 3 нет рёбер
+	graph.Freeze();
+	CheckLists(graph, "small graph");
+	Check(graph.GetIncidentEdges(3).begin() == graph.GetIncidentEdges(3).end(), "vertex without edges");
+
+	bool is_thrown = false;
+	try {
+		graph.AddEdge({ 0, 3, 1. });
+	}
+	catch (const logic_error&) {
+		is_thrown = true;
+	}
+	Check(is_thrown, "frozen graph rejects edges");
+
+	// достройка: новая вершина и рёбра к старым вершинам
+	graph.Unfreeze();
+	const graph::VertexId vertex = graph.AddVertex();
+	graph.AddEdge({ vertex, 0, 5. });
+	graph.AddEdge({ 1, vertex, 6. });
+	graph.AddEdge({ 0, 1, 7. });
+	graph.Freeze();
+	CheckLists(graph, "extended graph");
+}
+
+void TestRandomGraph() {
+	mt19937 random(7);
+	Graph graph(200);
+	for (int round = 0; round < 3; ++round) {
+		if (round > 0) {
+			graph.Unfreeze();
+			for (int i = 0; i < 20; ++i) {
+				graph.AddVertex();
+			}
+		}
+		uniform_int_distribution<graph::VertexId> vertex(0, graph.GetVertexCount() - 1);
+		for (int i = 0; i < 1500; ++i) {
+			graph.AddEdge({ vertex(random), vertex(random), static_cast<double>(random() % 1000) / 10. });
+		}
+		graph.Freeze();
+		CheckLists(graph, "random graph, round " + to_string(round));
+	}
+}
+
+}
+
+int main() {
+	TestSmallGraph();
+	TestRandomGraph();
+	if (is_ok) {
+		cout << "OK" << endl;
+	}
+	return is_ok ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+// Счётчики попаданий и промахов кэша маршрутов TransportRouter: одиночные запросы,
+// запросы из одной остановки в несколько, сброс кэша и отключённый кэш
+#include "transport_router.h"
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+bool is_ok = true;
+
+void Check(bool condition, const string& what) {
+	if (!condition) {
+		cerr << "FAILED: " << what << endl;
+		is_ok = false;
+	}
+}
+
+void CheckStats(const router::TransportRouter& router, size_t hits, size_t misses, const string& what) {
+	const router::RouteCacheStats stats = router.GetRouteCacheStats();
+	Check(stats.hits == hits && stats.misses == misses, what + ": hits " + to_string(stats.hits)
+		+ ", misses " + to_string(stats.misses) + ", expected " + to_string(hits) + ", " + to_string(misses));
+}
+
+void FillCatalogue(transport_db::TransportCatalogue& db) {
+	const StopId a = db.AddStop("A", { 43.0, 39.0 });
+	const StopId b = db.AddStop("B", { 43.01, 39.0 });
+	const StopId c = db.AddStop("C", { 43.02, 39.0 });
+	db.SetStopsDistance(a, b, 1000);
+	db.SetStopsDistance(b, c, 1500);
+	db.AddBus("1", { a, b, c }, false);
+}
+
+router::RoutingSettings MakeSettings(router::enRouterType router_type, int route_cache_size) {
+	router::RoutingSettings settings;
+	settings.bus_wait_time = 2;
+	settings.bus_velocity = 30;
+	settings.router_type = router_type;
+	settings.route_cache_size = route_cache_size;
+	return settings;
+}
+
+void TestSearchRouter() {
+	transport_db::TransportCatalogue db;
+	FillCatalogue(db);
+	router::TransportRouter router(db, MakeSettings(router::enRouterType::DIJKSTRA, 2));
+	router.InitGraph();
+	router.InitRouter();
+	router::RouteScratch scratch;
+
+	CheckStats(router, 0, 0, "new router");
+	Check(router.GetOptimalRoute("A", "C", scratch).has_value(), "route A-C");
+	CheckStats(router, 0, 1, "first A-C");
+	router.GetOptimalRoute("A", "C", scratch);
+	CheckStats(router, 1, 1, "second A-C");
+	// неизвестная остановка не доходит до кэша
+	router.GetOptimalRoute("A", "Nope", scratch);
+	CheckStats(router, 1, 1, "unknown stop");
+	// A-C уже в кэше, A-B ищется в дереве путей
+	router.GetOptimalRoutes("A", { "B", "C" }, scratch);
+	CheckStats(router, 2, 2, "batch A-B, A-C");
+	// в кэше два маршрута: C-A вытесняет A-C, самый давний после обращений выше
+	router.GetOptimalRoute("C", "A", scratch);
+	router.GetOptimalRoute("A", "C", scratch);
+	CheckStats(router, 2, 4, "eviction");
+
+	router.InitRouteCache();
+	CheckStats(router, 0, 0, "cache reset");
+}
+
+void TestPerTargetRouter() {
+	transport_db::TransportCatalogue db;
+	FillCatalogue(db);
+	router::TransportRouter router(db, MakeSettings(router::enRouterType::HUB_LABELS, 10));
+	router.InitGraph();
+	router.InitRouter();
+	router::RouteScratch scratch;
+
+	// метки хабов отвечают на каждую пару отдельно, повтор пары - попадание
+	router.GetOptimalRoutes("C", { "A", "A", "B" }, scratch);
+	CheckStats(router, 1, 2, "per-target batch");
+}
+
+void TestDisabledCache() {
+	transport_db::TransportCatalogue db;
+	FillCatalogue(db);
+	router::TransportRouter router(db, MakeSettings(router::enRouterType::DIJKSTRA, 0));
+	router.InitGraph();
+	router.InitRouter();
+	router::RouteScratch scratch;
+
+	const auto route = router.GetOptimalRoute("A", "C", scratch);
+	router.GetOptimalRoute("A", "C", scratch);
+	router.GetOptimalRoutes("A", { "B", "C" }, scratch);
+	CheckStats(router, 0, 0, "disabled cache");
+	Check(route.has_value() && route->total_time == 7., "route without cache");
+}
+
+}
+
+int main() {
+	TestSearchRouter();
+	TestPerTargetRouter();
+	TestDisabledCache();
+	if (is_ok) {
+		cout << "OK" << endl;
+	}
+	return is_ok ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+// Замер построения таблицы маршрутов all_pairs на синтетических графах:
+// router_benchmark [число вершин ...], по умолчанию 2000 и 4000 вершин.
+// Таблица graph::Router сравнивается с прямым скалярным циклом Флойда-Уоршелла
+// без полос по тем же плоским массивам: веса и последние рёбра должны совпасть побитово
+#include "router.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const size_t EDGES_PER_VERTEX = 4;
+const uint32_t NO_EDGE = numeric_limits<uint32_t>::max();
+
+graph::DirectedWeightedGraph<double> MakeGraph(size_t vertex_count) {
+	mt19937 generator(static_cast<uint32_t>(vertex_count));
+	uniform_int_distribution<graph::VertexId> vertex(0, static_cast<graph::VertexId>(vertex_count - 1));
+	uniform_int_distribution<int> weight(1, 1000);
+	graph::DirectedWeightedGraph<double> result(vertex_count);
+	for (graph::VertexId from = 0; from < vertex_count; ++from) {
+		for (size_t i = 0; i < EDGES_PER_VERTEX; ++i) {
+			result.AddEdge({ from, vertex(generator), weight(generator) / 7. });
+		}
+	}
+	result.Freeze();
+	return result;
+}
+
+// таблица прежним циклом: строки целиком, без векторных команд
+struct Table {
+	vector<double> weights;
+	vector<uint32_t> prev_edges;
+};
+
+Table BuildTable(const graph::DirectedWeightedGraph<double>& graph) {
+	const size_t n = graph.GetVertexCount();
+	Table table{ vector<double>(n * n, numeric_limits<double>::infinity()), vector<uint32_t>(n * n, NO_EDGE) };
+	for (graph::VertexId vertex = 0; vertex < n; ++vertex) {
+		table.weights[vertex * n + vertex] = 0;
+		for (const auto& edge : graph.GetIncidentEdges(vertex)) {
+			const size_t index = vertex * n + edge.to;
+			if (table.weights[index] > edge.weight) {
+				table.weights[index] = edge.weight;
+				table.prev_edges[index] = static_cast<uint32_t>(edge.id);
+			}
+		}
+	}
+	for (size_t through = 0; through < n; ++through) {
+		for (size_t from = 0; from < n; ++from) {
+			const double weight_from = table.weights[from * n + through];
+			if (weight_from == numeric_limits<double>::infinity()) {
+				continue;
+			}
+			graph::detail::RelaxRowSegmentScalar(&table.weights[from * n], &table.prev_edges[from * n],
+				&table.weights[through * n], &table.prev_edges[through * n],
+				weight_from, table.prev_edges[from * n + through], NO_EDGE, 0, n);
+		}
+	}
+	return table;
+}
+
+size_t CountMismatches(const graph::Router<double>& router, const Table& table, size_t n) {
+	size_t mismatches = 0;
+	vector<graph::EdgeId> edges;
+	for (graph::VertexId from = 0; from < n; ++from) {
+		for (graph::VertexId to = 0; to < n; ++to) {
+			const double expected = table.weights[from * n + to];
+			const auto weight = router.BuildRoute(from, to, edges);
+			if (expected == numeric_limits<double>::infinity()) {
+				mismatches += weight ? 1 : 0;
+			}
+			else if (!weight || *weight != expected
+				|| (from != to && (edges.empty() || edges.back() != table.prev_edges[from * n + to]))) {
+				++mismatches;
+			}
+		}
+	}
+	return mismatches;
+}
+
+double SecondsSince(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+}
+
+int main(int argc, char* argv[]) {
+	vector<size_t> sizes;
+	for (int i = 1; i < argc; ++i) {
+		sizes.push_back(stoul(argv[i]));
+	}
+	if (sizes.empty()) {
+		sizes = { 2000, 4000 };
+	}
+
+	bool is_equal = true;
+	cout << "vertices\tscalar, s\trouter, s\tspeedup\tmismatches" << endl;
+	for (size_t n : sizes) {
+		const auto graph = MakeGraph(n);
+		auto start = chrono::steady_clock::now();
+		const Table table = BuildTable(graph);
+		const double scalar_time = SecondsSince(start);
+		start = chrono::steady_clock::now();
+		const graph::Router<double> router(graph);
+		const double router_time = SecondsSince(start);
+		const size_t mismatches = CountMismatches(router, table, n);
+		is_equal = is_equal && mismatches == 0;
+		cout << n << '\t' << fixed << setprecision(2) << scalar_time << '\t' << router_time << '\t'
+			<< scalar_time / router_time << '\t' << mismatches << endl;
+	}
+	return is_equal ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+// Расстояния SpansMap: обратное расстояние как запасное, явное расстояние не затирается обратным,
+// обход только явных расстояний и сверка со словарём на большом числе пар
+#include "spans_map.h"
+
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+namespace {
+
+bool is_ok = true;
+
+void Check(bool condition, const string& what) {
+	if (!condition) {
+		cerr << "FAILED: " << what << endl;
+		is_ok = false;
+	}
+}
+
+void TestDirections() {
+	transport_db::SpansMap spans;
+	Check(!spans.Find(0, 1).has_value(), "empty map");
+
+	spans.Set(0, 1, 1000);
+	Check(spans.Find(0, 1) == 1000, "direct distance");
+	Check(spans.Find(1, 0) == 1000, "reverse distance");
+	Check(!spans.Find(0, 2).has_value(), "missing pair");
+
+	// своё расстояние для обратной пары заменяет запасное, но не прямое
+	spans.Set(1, 0, 1200);
+	Check(spans.Find(0, 1) == 1000 && spans.Find(1, 0) == 1200, "asymmetric distances");
+	// повторное задание прямой пары не затирает обратную
+	spans.Set(0, 1, 900);
+	Check(spans.Find(0, 1) == 900 && spans.Find(1, 0) == 1200, "direct distance reset");
+
+	spans.Set(2, 2, 50);
+	Check(spans.Find(2, 2) == 50, "distance to the same stop");
+
+	map<pair<StopId, StopId>, int> direct;
+	spans.ForEach([&direct](StopId from, StopId to, int distance) {
+		direct[{ from, to }] = distance;
+	});
+	const map<pair<StopId, StopId>, int> expected = { { { 0, 1 }, 900 }, { { 1, 0 }, 1200 }, { { 2, 2 }, 50 } };
+	Check(direct == expected, "ForEach visits direct distances only");
+}
+
+// пары с одинаковыми младшими битами ключа и случайные пары вперемешку: таблица много раз
+// перестраивается, ответы совпадают со словарём
+void TestAgainstMap() {
+	transport_db::SpansMap spans;
+	map<pair<StopId, StopId>, int> direct;
+	mt19937 random(42);
+	uniform_int_distribution<StopId> stop_id(0, 300);
+	for (int i = 0; i < 20000; ++i) {
+		const StopId from = i % 2 == 0 ? stop_id(random) : static_cast<StopId>(i % 64) << 16;
+		const StopId to = stop_id(random);
+		const int distance = static_cast<int>(random() % 100000);
+		spans.Set(from, to, distance);
+		direct[{ from, to }] = distance;
+	}
+
+	size_t mismatches = 0;
+	auto expected_distance = [&direct](StopId from, StopId to) -> optional<int> {
+		if (auto it = direct.find({ from, to }); it != direct.end()) {
+			return it->second;
+		}
+		if (auto it = direct.find({ to, from }); it != direct.end()) {
+			return it->second;
+		}
+		return nullopt;
+	};
+	for (const auto& [stops, distance] : direct) {
+		mismatches += spans.Find(stops.first, stops.second) != distance;
+		mismatches += spans.Find(stops.second, stops.first) != expected_distance(stops.second, stops.first);
+	}
+	for (int i = 0; i < 20000; ++i) {
+		const StopId from = stop_id(random) + 1000;
+		const StopId to = stop_id(random);
+		mismatches += spans.Find(from, to).has_value();
+	}
+	Check(mismatches == 0, "lookups match the map: " + to_string(mismatches) + " mismatches");
+
+	size_t visited = 0;
+	spans.ForEach([&](StopId from, StopId to, int distance) {
+		++visited;
+		Check(direct.at({ from, to }) == distance, "ForEach distance");
+	});
+	Check(visited == direct.size(), "ForEach visits every direct distance");
+}
+
+}
+
+int main() {
+	TestDirections();
+	TestAgainstMap();
+	if (is_ok) {
+		cout << "OK" << endl;
+	}
+	return is_ok ? 0 : 1;
+}
@@ -3,138 +3,158 @@
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
 
 using namespace std;
 
 namespace transport_db {
 
-void TransportCatalogue::AddStop(const Stop& stop) {
-	stops_.push_back(stop);
-	Stop& last_added = stops_.back();
-	stopname_to_stop_.insert({ last_added.name, &last_added });
-	stopname_to_buses_[last_added.name];
+StopId TransportCatalogue::AddStop(string name, geo::Coordinates coord) {
+	if (stopname_to_id_.count(name) > 0) {
+		throw invalid_argument("Stop "s + name + " already exists"s);
+	}
+	const StopId id = static_cast<StopId>(stops_.size());
+	stops_.push_back({ move(name), coord, id });
+	stopname_to_id_.emplace(names_.emplace_back(stops_.back().name), id);
+	stop_buses_.emplace_back();
+	return id;
 }
 
-void TransportCatalogue::SetStopsDistance(string from, string to, int distance) {
-	auto stop_from = FindStop(from);
-	if (stop_from != nullptr) {
-		auto stop_to = FindStop(to);
-		if (stop_to != nullptr) {
-			detail::StopsPair key{ stop_from, stop_to };
-			stops_distance_[key] = distance;
-		}
-		else {
-			//cout << "Next Stop Not Found!" << endl;
-		}
-	}
-	else {
-		//cout << "Base Stop Not Found!" << endl;
-	}
+void TransportCatalogue::SetStopsDistance(StopId from, StopId to, int distance) {
+	stops_distance_.Set(from, to, distance);
 }
 
 const Stop* TransportCatalogue::FindStop(string_view stop_name) const {
-	if (stopname_to_stop_.count(stop_name)) {
-		return stopname_to_stop_.at(stop_name);
+	if (auto it = stopname_to_id_.find(stop_name); it != stopname_to_id_.end()) {
+		return &stops_[it->second];
 	}
 	return nullptr;
 }
 
-void TransportCatalogue::AddBus(const string& name, const vector<string>& stops, bool is_roundtrip) {
-	Bus bus;
-
-	bus.name = name;
-
-	for (auto stop : stops) {
-		auto s = FindStop(stop);
-		if (s != nullptr) {
-			bus.route.push_back(s);
-		}
-		else {
-			//cout << "Stop Not Found!" << endl;
-		}
+BusId TransportCatalogue::AddBus(string name, vector<StopId> stops, bool is_roundtrip) {
+	if (busname_to_id_.count(name) > 0) {
+		throw invalid_argument("Bus "s + name + " already exists"s);
 	}
-
-	bus.is_roundtrip = is_roundtrip;
-
-	buses_.push_back(move(bus));
-	Bus& last_added = buses_.back();
-	busname_to_bus_.insert({ last_added.name, &last_added });
-	for (auto stop : stops) {
-		stopname_to_buses_[stop].insert(&last_added);
+	const BusId id = static_cast<BusId>(buses_.size());
+	for (StopId stop : stops) {
+		// автобусы добавляются по возрастанию номера, поэтому списки остаются упорядоченными
+		auto& stop_buses = stop_buses_.at(stop);
+		if (stop_buses.empty() || stop_buses.back() != id) {
+			stop_buses.push_back(id);
+		}
 	}
+	buses_.push_back({ move(name), move(stops), is_roundtrip, id });
+	busname_to_id_.emplace(names_.emplace_back(buses_.back().name), id);
+	return id;
 }
 
 const Bus* TransportCatalogue::FindBus(string_view bus_name) const {
-	if (busname_to_bus_.count(bus_name)) {
-		return busname_to_bus_.at(bus_name);
+	if (auto it = busname_to_id_.find(bus_name); it != busname_to_id_.end()) {
+		return &buses_[it->second];
 	}
 	return nullptr;
 }
 
-optional<StopBuses> TransportCatalogue::GetBusesNamesByStop(const string_view& stop_name) const {
-	optional<StopBuses> ret;
-	if (stopname_to_buses_.count(stop_name)) {
-		if (stopname_to_buses_.at(stop_name).size() == 0) {
-			ret = nullptr;
-			//return nullptr;
-		}
-		else {
-			ret = { &(stopname_to_buses_.at(stop_name)) };
-			//return { &(stopname_to_buses_.at(stop_name)) };
-		}
-	}
-	return ret;
+const Stop& TransportCatalogue::GetStop(StopId id) const {
+	return stops_[id];
 }
 
-AllBusesPtr TransportCatalogue::GetAllBuses() const {
-	return &busname_to_bus_;
+const Bus& TransportCatalogue::GetBus(BusId id) const {
+	return buses_[id];
 }
 
-double TransportCatalogue::ComputeRealRouteDistance(const Bus* bus) {
-	double distance = 0;
-	auto route = bus->route;
-	for (auto it = next(route.begin()); it < route.end(); ++it) {
-		distance += GetStopsDistance({ *prev(it), *it });
-	}
-	return distance;
+const vector<BusId>& TransportCatalogue::GetStopBuses(StopId id) const {
+	return stop_buses_[id];
 }
 
-double TransportCatalogue::ComputeGeoRouteDistance(const Bus* bus) {
-	double geo_distance = 0;
-	auto route = bus->route;
-	for (auto it = next(route.begin()); it < route.end(); ++it) {
-		geo_distance += ComputeDistance((*prev(it))->coord, (*it)->coord);
+void TransportCatalogue::ComputeRouteStats(size_t thread_count) {
+	const size_t first_bus = route_stats_.size();
+	route_stats_.resize(buses_.size());
+	if (first_bus == buses_.size()) {
+		return;
 	}
-	return geo_distance;
-}
 
-double TransportCatalogue::GetStopsDistance(const detail::StopsPair& stops) const {
-	if (stops_distance_.count(stops)) {
-		return stops_distance_.at(stops);
+	// автобусы разной длины, поэтому раздаются по одному; каждый поток пишет только свои ячейки
+	atomic<size_t> next_bus = first_bus;
+	auto compute_stats = [this, &next_bus]() {
+		for (size_t bus = next_bus++; bus < buses_.size(); bus = next_bus++) {
+			route_stats_[bus] = ComputeBusStats(buses_[bus]);
+		}
+	};
+	thread_count = max(min(thread_count, buses_.size() - first_bus), size_t{ 1 });
+	vector<thread> threads;
+	threads.reserve(thread_count - 1);
+	for (size_t thread_index = 1; thread_index < thread_count; ++thread_index) {
+		threads.emplace_back(compute_stats);
 	}
-	else if (stops_distance_.count({ stops.second, stops.first })) {
-		return stops_distance_.at({ stops.second, stops.first });
+	compute_stats();
+	for (auto& thread : threads) {
+		thread.join();
 	}
-	else {
-		//cout << "Distance not found"s << endl;
+}
+
+const RouteStats& TransportCatalogue::GetRouteStats(BusId id) const {
+	return route_stats_.at(id);
+}
+
+// Некольцевой маршрут проходится туда и обратно без копирования: остановка с номером i
+// в полном маршруте берётся с конца, если i выходит за прямой путь
+RouteStats TransportCatalogue::ComputeBusStats(const Bus& bus) const {
+	RouteStats route_stats;
+	const auto& route = bus.route;
+	if (route.empty()) {
+		return route_stats;
+	}
+	route_stats.stop_count = bus.is_roundtrip ? route.size() : route.size() * 2 - 1;
+	auto stop_at = [&route](size_t i) {
+		return i < route.size() ? route[i] : route[route.size() * 2 - 2 - i];
+	};
+
+	double geo_length = 0;
+	for (size_t i = 1; i < route_stats.stop_count; ++i) {
+		route_stats.route_length += GetStopsDistance(stop_at(i - 1), stop_at(i));
+		geo_length += ComputeDistance(stops_[stop_at(i - 1)].coord, stops_[stop_at(i)].coord);
 	}
-	return 0;
+	route_stats.curvative = route_stats.route_length / geo_length;
+
+	vector<StopId> unique_stops(route);
+	sort(unique_stops.begin(), unique_stops.end());
+	route_stats.unique_stop_count = unique(unique_stops.begin(), unique_stops.end()) - unique_stops.begin();
+	return route_stats;
 }
 
-const std::deque<Stop>& TransportCatalogue::GetStops() const {
-	return stops_;
+void TransportCatalogue::BuildStopsIndex() {
+	stops_index_.Build(stops_);
 }
 
-const std::deque<Bus>& TransportCatalogue::GetBuses() const {
-	return buses_;
+vector<NearbyStop> TransportCatalogue::FindNearestStops(geo::Coordinates coord, size_t count) const {
+	return stops_index_.FindNearest(stops_, coord, count);
 }
 
-std::deque<Stop>& TransportCatalogue::GetStops() {
+vector<NearbyStop> TransportCatalogue::FindStopsWithin(geo::Coordinates coord, double radius) const {
+	return stops_index_.FindWithin(stops_, coord, radius);
+}
+
+void TransportCatalogue::BuildStopNamesIndex() {
+	stop_names_index_.Build(stops_);
+}
+
+vector<StopMatch> TransportCatalogue::FindStopsByName(string_view query, size_t count, size_t max_edits) const {
+	return stop_names_index_.Find(stops_, query, count, max_edits);
+}
+
+double TransportCatalogue::GetStopsDistance(StopId from, StopId to) const {
+	return stops_distance_.Find(from, to).value_or(0);
+}
+
+const std::vector<Stop>& TransportCatalogue::GetStops() const {
 	return stops_;
 }
 
-std::deque<Bus>& TransportCatalogue::GetBuses() {
+const std::vector<Bus>& TransportCatalogue::GetBuses() const {
 	return buses_;
 }
 
-}
\ No newline at end of file
+}
@@ -3,6 +3,9 @@
 #include "geo.h"
 #include "domain.h"
 #include "ranges.h"
+#include "spans_map.h"
+#include "stop_names_index.h"
+#include "stops_index.h"
 
 #include <deque>
 #include <vector>
@@ -21,48 +24,70 @@ namespace ptb {
 namespace transport_db {
 
 namespace detail {
-	using StopsDistance = std::pair<std::string, std::string>;
-	using StopsPair = std::pair<const Stop*, const Stop*>;
+	using StopsPair = std::pair<StopId, StopId>;
 	struct StopsHasher {
 		size_t operator() (const StopsPair& key) const {
-			return v_hasher_(key.first) + v_hasher_(key.second) * 37;
+			return v_hasher_((static_cast<uint64_t>(key.first) << 32) | key.second);
 		}
 	private:
-		std::hash<const void*> v_hasher_;
+		std::hash<uint64_t> v_hasher_;
 	};
 }
 
-using SpansMap = std::unordered_map<detail::StopsPair, int, detail::StopsHasher>;
-using SpansBusesMap = std::unordered_map<detail::StopsPair, std::vector<BusPtr>, detail::StopsHasher>;
-
+// Остановки и автобусы лежат в массивах по своим номерам, все связи между ними - номера.
+// Указатели на элементы действительны до следующего добавления
 class TransportCatalogue
 {
 	friend ptb::Protobuffer;
 public:
+	TransportCatalogue() = default;
+	// ключи поиска по имени смотрят в строки самого каталога: копия ссылалась бы на чужие,
+	// а перенос оставляет строки на месте
+	TransportCatalogue(const TransportCatalogue&) = delete;
+	TransportCatalogue& operator=(const TransportCatalogue&) = delete;
+	TransportCatalogue(TransportCatalogue&&) = default;
+	TransportCatalogue& operator=(TransportCatalogue&&) = default;
 
-	void AddStop(const Stop& stop);
-	void SetStopsDistance(std::string from, std::string to, int distance);
-	void AddBus(const std::string& name, const std::vector<std::string>& stops, bool is_roundtrip);
+	StopId AddStop(std::string name, geo::Coordinates coord);
+	void SetStopsDistance(StopId from, StopId to, int distance);
+	BusId AddBus(std::string name, std::vector<StopId> stops, bool is_roundtrip);
 	const Stop* FindStop(std::string_view stop_name) const;
 	BusPtr FindBus(std::string_view bus_name) const;
-	std::optional<StopBuses> GetBusesNamesByStop(const std::string_view& stop_name) const;
-	AllBusesPtr GetAllBuses() const;
-	const std::deque<Stop>& GetStops() const;
-	const std::deque<Bus>& GetBuses() const;
-	double GetStopsDistance(const detail::StopsPair& stops) const;
-	double ComputeRealRouteDistance(BusPtr bus);
-	double ComputeGeoRouteDistance(BusPtr bus);
-
-	std::deque<Stop>& GetStops();
-	std::deque<Bus>& GetBuses();
+	const Stop& GetStop(StopId id) const;
+	const Bus& GetBus(BusId id) const;
+	// номера автобусов, проходящих через остановку, по возрастанию
+	const std::vector<BusId>& GetStopBuses(StopId id) const;
+	const std::vector<Stop>& GetStops() const;
+	const std::vector<Bus>& GetBuses() const;
+	double GetStopsDistance(StopId from, StopId to) const;
+	// Считает статистику автобусов, добавленных после прошлого вызова, в thread_count потоков.
+	// Статистика уже посчитанных автобусов не меняется: новые остановки не входят в их маршруты
+	void ComputeRouteStats(size_t thread_count);
+	const RouteStats& GetRouteStats(BusId id) const;
+	// Перестраивает пространственный индекс по всем остановкам
+	void BuildStopsIndex();
+	std::vector<NearbyStop> FindNearestStops(geo::Coordinates coord, size_t count) const;
+	std::vector<NearbyStop> FindStopsWithin(geo::Coordinates coord, double radius) const;
+	// Перестраивает индекс имён остановок
+	void BuildStopNamesIndex();
+	std::vector<StopMatch> FindStopsByName(std::string_view query, size_t count, size_t max_edits) const;
 
 private:
-	std::deque<Stop> stops_;
-	std::deque<Bus> buses_;
-	std::unordered_map<std::string_view, const Stop*> stopname_to_stop_;
-	std::unordered_map<std::string_view, BusPtr> busname_to_bus_;
-	std::unordered_map<std::string_view, std::set<BusPtr>> stopname_to_buses_;
+	RouteStats ComputeBusStats(const Bus& bus) const;
+
+	std::vector<Stop> stops_;
+	std::vector<Bus> buses_;
+	// ключи смотрят в names_: строки массивов переезжают при их росте, а элементы deque - нет,
+	// поэтому поиск по имени не создаёт строку
+	std::deque<std::string> names_;
+	std::unordered_map<std::string_view, StopId> stopname_to_id_;
+	std::unordered_map<std::string_view, BusId> busname_to_id_;
+	std::vector<std::vector<BusId>> stop_buses_;
+	// статистика по номеру автобуса
+	std::vector<RouteStats> route_stats_;
 	SpansMap stops_distance_;
+	StopsIndex stops_index_;
+	StopNamesIndex stop_names_index_;
 };
 
-}
\ No newline at end of file
+}
@@ -1,9 +1,122 @@
 #include "transport_router.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <thread>
+
 using namespace std;
 
 namespace router {
 
+namespace {
+
+// Номер клетки решётки 2^16 x 2^16 на кривой Гильберта
+uint64_t HilbertIndex(uint32_t x, uint32_t y) {
+	constexpr uint32_t SIDE = 1u << 16;
+	uint64_t index = 0;
+	for (uint32_t s = SIDE / 2; s > 0; s /= 2) {
+		const uint32_t rx = (x & s) > 0 ? 1 : 0;
+		const uint32_t ry = (y & s) > 0 ? 1 : 0;
+		index += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+		if (ry == 0) {
+			if (rx == 1) {
+				x = SIDE - 1 - x;
+				y = SIDE - 1 - y;
+			}
+			swap(x, y);
+		}
+	}
+	return index;
+}
+
+// Вершины упорядочиваются по номеру клетки их остановки на кривой Гильберта
+vector<graph::VertexId> ComputeHilbertOrder(const vector<StopId>& vertex_to_stop, const vector<::Stop>& stops) {
+	double min_lat = numeric_limits<double>::max(), max_lat = numeric_limits<double>::lowest();
+	double min_lng = numeric_limits<double>::max(), max_lng = numeric_limits<double>::lowest();
+	for (const StopId stop : vertex_to_stop) {
+		min_lat = min(min_lat, stops[stop].coord.lat);
+		max_lat = max(max_lat, stops[stop].coord.lat);
+		min_lng = min(min_lng, stops[stop].coord.lng);
+		max_lng = max(max_lng, stops[stop].coord.lng);
+	}
+	auto to_cell = [](double value, double min_value, double max_value) {
+		constexpr double MAX_CELL = (1u << 16) - 1;
+		return IsZero(max_value - min_value) ? 0u
+			: static_cast<uint32_t>((value - min_value) / (max_value - min_value) * MAX_CELL);
+	};
+
+	vector<pair<uint64_t, graph::VertexId>> keys;
+	keys.reserve(vertex_to_stop.size());
+	for (graph::VertexId vertex = 0; vertex < vertex_to_stop.size(); ++vertex) {
+		const auto& coord = stops[vertex_to_stop[vertex]].coord;
+		keys.push_back({ HilbertIndex(to_cell(coord.lng, min_lng, max_lng), to_cell(coord.lat, min_lat, max_lat)), vertex });
+	}
+	sort(keys.begin(), keys.end());
+
+	vector<graph::VertexId> order;
+	order.reserve(keys.size());
+	for (const auto& key : keys) {
+		order.push_back(key.second);
+	}
+	return order;
+}
+
+// Обход в ширину без учёта направления рёбер от вершины наименьшей степени в каждой компоненте,
+// соседи - по возрастанию степени, итоговый порядок обращается
+vector<graph::VertexId> ComputeRcmOrder(const graph::DirectedWeightedGraph<double>& graph) {
+	const size_t vertex_count = graph.GetVertexCount();
+	vector<size_t> degrees(vertex_count);
+	for (graph::VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+		const auto outgoing = graph.GetIncidentEdges(vertex);
+		const auto incoming = graph.GetIncomingEdges(vertex);
+		degrees[vertex] = (outgoing.end() - outgoing.begin()) + (incoming.end() - incoming.begin());
+	}
+	vector<graph::VertexId> by_degree(vertex_count);
+	for (graph::VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+		by_degree[vertex] = vertex;
+	}
+	stable_sort(by_degree.begin(), by_degree.end(), [&degrees](graph::VertexId lhs, graph::VertexId rhs) {
+		return degrees[lhs] < degrees[rhs];
+	});
+
+	vector<graph::VertexId> order;
+	order.reserve(vertex_count);
+	vector<bool> visited(vertex_count, false);
+	vector<graph::VertexId> neighbours;
+	for (graph::VertexId start : by_degree) {
+		if (visited[start]) {
+			continue;
+		}
+		visited[start] = true;
+		order.push_back(start);
+		for (size_t head = order.size() - 1; head < order.size(); ++head) {
+			const graph::VertexId vertex = order[head];
+			neighbours.clear();
+			for (const auto& edge : graph.GetIncidentEdges(vertex)) {
+				neighbours.push_back(edge.to);
+			}
+			for (const auto& edge : graph.GetIncomingEdges(vertex)) {
+				neighbours.push_back(edge.to);
+			}
+			stable_sort(neighbours.begin(), neighbours.end(), [&degrees](graph::VertexId lhs, graph::VertexId rhs) {
+				return degrees[lhs] < degrees[rhs];
+			});
+			for (graph::VertexId neighbour : neighbours) {
+				if (!visited[neighbour]) {
+					visited[neighbour] = true;
+					order.push_back(neighbour);
+				}
+			}
+		}
+	}
+	reverse(order.begin(), order.end());
+	return order;
+}
+
+}  // namespace
+
 TransportRouter::TransportRouter(const transport_db::TransportCatalogue& db)
 	: db_(db)
 {
@@ -21,98 +134,556 @@ TransportRouter::TransportRouter(const transport_db::TransportCatalogue& db,
 }
 
 void TransportRouter::InitGraph() {
-	graph_ = make_unique<graph::DirectedWeightedGraph<double>>(db_.GetStops().size() * 2);
+	size_t vertex_count = db_.GetStops().size() * 2;
+	if (settings_.graph_model == enGraphModel::LINES) {
+		for (const auto& bus : db_.GetBuses()) {
+			vertex_count += bus.route.size() * (bus.is_roundtrip ? 1 : 2);
+		}
+	}
+	graph_ = make_unique<graph::DirectedWeightedGraph<double>>(vertex_count);
 }
 
 void TransportRouter::InitRouter() {
 	AddVertexesToGraph();
 	AddEdgesToGraph();
+	graph_->Freeze();
+	RenumberVertices();
 
-	router_ = make_unique<graph::Router<double>>(*graph_);
+	InitRouterEngine();
+	InitRouteCache();
+}
+
+void TransportRouter::InitRouteCache() {
+	lock_guard lock(route_cache_mutex_);
+	route_cache_.Clear();
+	route_cache_.SetCapacity(max(settings_.route_cache_size, 0));
+	route_cache_hits_ = 0;
+	route_cache_misses_ = 0;
+}
+
+void TransportRouter::InitSearchRouter() {
+	dijkstra_router_ = make_unique<graph::DijkstraRouter<double>>(*graph_);
+}
+
+void TransportRouter::InitRouterEngine() {
+	InitSearchRouter();
+	switch (settings_.router_type) {
+	case enRouterType::ALL_PAIRS:
+		router_ = make_unique<graph::Router<double>>(*graph_, GetBuildThreadCount());
+		break;
+	case enRouterType::DIJKSTRA:
+	case enRouterType::BIDIRECTIONAL:
+		router_.reset();
+		break;
+	case enRouterType::CONTRACTION_HIERARCHIES:
+		router_.reset();
+		ch_router_ = make_unique<graph::ContractionHierarchyRouter<double>>(*graph_);
+		break;
+	case enRouterType::ASTAR:
+		router_.reset();
+		heuristic_scale_ = ComputeHeuristicScale();
+		break;
+	case enRouterType::LAZY_ROWS:
+		router_.reset();
+		lazy_router_ = make_unique<graph::LazyRouter<double>>(*graph_, max(settings_.route_rows_limit, 0));
+		break;
+	case enRouterType::HUB_LABELS:
+		router_.reset();
+		hub_router_ = make_unique<graph::HubLabelRouter<double>>(*graph_);
+		break;
+	}
+}
+
+void TransportRouter::AddStop(StopId stop) {
+	if (stop < stop_to_vertex_id_.size() && stop_to_vertex_id_[stop].first != NO_VERTEX) {
+		throw invalid_argument("Stop "s + db_.GetStop(stop).name + " is already routed"s);
+	}
+	const graph::EdgeId first_edge = graph_->GetEdgeCount();
+	graph_->Unfreeze();
+	last_vertex_id_ = graph_->GetVertexCount();
+	graph_->AddVertex();
+	graph_->AddVertex();
+	auto [from, to] = AddVertexId(stop);
+	AddWaitEdge(from, to, stop);
+	if (!vertex_permutation_.empty()) {
+		vertex_permutation_.push_back(from);
+		vertex_permutation_.push_back(to);
+	}
+	graph_->Freeze();
+	UpdateRouterEngine(first_edge);
+}
+
+void TransportRouter::AddBus(BusId bus_id) {
+	const graph::EdgeId first_edge = graph_->GetEdgeCount();
+	const ::Bus& bus = db_.GetBus(bus_id);
+	graph_->Unfreeze();
+	last_vertex_id_ = graph_->GetVertexCount();
+	if (settings_.graph_model == enGraphModel::LINES) {
+		const size_t vertex_count = bus.route.size() * (bus.is_roundtrip ? 1 : 2);
+		for (size_t i = 0; i < vertex_count; ++i) {
+			const graph::VertexId vertex = graph_->AddVertex();
+			if (!vertex_permutation_.empty()) {
+				vertex_permutation_.push_back(vertex);
+			}
+		}
+	}
+	AddBusToGraph(bus);
+	graph_->Freeze();
+	UpdateRouterEngine(first_edge);
+}
+
+// Таблица всех маршрутов и строки lazy_rows обновляются частично, поиск по запросу читает граф
+// напрямую, а сжатие иерархий и метки хабов не имеют частичного обновления и строятся заново
+void TransportRouter::UpdateRouterEngine(graph::EdgeId first_edge) {
+	switch (settings_.router_type) {
+	case enRouterType::ALL_PAIRS:
+		router_->Update(first_edge);
+		break;
+	case enRouterType::DIJKSTRA:
+	case enRouterType::BIDIRECTIONAL:
+		break;
+	case enRouterType::ASTAR:
+		heuristic_scale_ = ComputeHeuristicScale();
+		break;
+	case enRouterType::LAZY_ROWS:
+		lazy_router_->Update(first_edge);
+		break;
+	case enRouterType::CONTRACTION_HIERARCHIES:
+	case enRouterType::HUB_LABELS:
+		InitRouterEngine();
+		break;
+	}
+	// готовые ответы могли устареть
+	InitRouteCache();
 }
 
 void TransportRouter::AddVertexesToGraph() {
-	const auto& all_stops = db_.GetStops();
 	// пронумеруем остановки каждого маршрута
-	for (const ::Stop& stop : all_stops) {
-		auto [from, to] = AddVertexId(&stop);
-		AddWaitEdge(from, to, &stop);
+	for (const auto& stop : db_.GetStops()) {
+		auto [from, to] = AddVertexId(stop.id);
+		AddWaitEdge(from, to, stop.id);
 	}
 }
 
 void TransportRouter::AddEdgesToGraph() {
 	// добавляем рёбра между остановками для каждого маршрута
-	const auto& all_buses = db_.GetBuses();
-	for (const auto& bus : all_buses) {
-		AddEdgesFromBus(bus.route.begin(), bus.route.end(), &bus);
+	for (const auto& bus : db_.GetBuses()) {
+		AddBusToGraph(bus);
+	}
+}
+
+void TransportRouter::AddBusToGraph(const ::Bus& bus) {
+	if (settings_.graph_model == enGraphModel::LINES) {
+		AddLineFromBus(bus.route.begin(), bus.route.end(), bus.id);
 		if (bus.is_roundtrip == false) {
-			AddEdgesFromBus(bus.route.rbegin(), bus.route.rend(), &bus);
+			AddLineFromBus(bus.route.rbegin(), bus.route.rend(), bus.id);
 		}
+		return;
+	}
+	AddEdgesFromBus(bus.route.begin(), bus.route.end(), bus.id);
+	if (bus.is_roundtrip == false) {
+		AddEdgesFromBus(bus.route.rbegin(), bus.route.rend(), bus.id);
 	}
 }
 
-void TransportRouter::AddWaitEdge(graph::VertexId from, graph::VertexId to, const Stop* stop) {
-	auto item = WaitItem{ stop->name, settings_.bus_wait_time };
-	graph::EdgeId id = AddEdge(from, to, (double)settings_.bus_wait_time);
-	edge_id_to_item_[id] = item;
+// Соседние по номеру вершины оказываются рядом на карте или в графе, поэтому строки таблицы
+// маршрутов и списки смежности, к которым обращается поиск, чаще лежат рядом в памяти.
+// Номера рёбер не меняются, поэтому edge_items_ остаётся прежним
+void TransportRouter::RenumberVertices() {
+	const size_t vertex_count = graph_->GetVertexCount();
+	vector<graph::VertexId> order;
+	switch (settings_.vertex_order) {
+	case enVertexOrder::INSERTION:
+		return;
+	case enVertexOrder::HILBERT:
+		order = ComputeHilbertOrder(vertex_to_stop_, db_.GetStops());
+		break;
+	case enVertexOrder::RCM:
+		order = ComputeRcmOrder(*graph_);
+		break;
+	}
+
+	vertex_permutation_.resize(vertex_count);
+	for (graph::VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+		vertex_permutation_[order[vertex]] = vertex;
+	}
+
+	auto graph = make_unique<graph::DirectedWeightedGraph<double>>(vertex_count);
+	for (graph::EdgeId edge_id = 0; edge_id < graph_->GetEdgeCount(); ++edge_id) {
+		const auto& edge = graph_->GetEdge(edge_id);
+		graph->AddEdge({ vertex_permutation_[edge.from], vertex_permutation_[edge.to], edge.weight });
+	}
+	graph->Freeze();
+	graph_ = move(graph);
+
+	for (auto& vertexes : stop_to_vertex_id_) {
+		if (vertexes.first != NO_VERTEX) {
+			vertexes = { vertex_permutation_[vertexes.first], vertex_permutation_[vertexes.second] };
+		}
+	}
+	vector<StopId> vertex_to_stop(vertex_count);
+	for (graph::VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+		vertex_to_stop[vertex_permutation_[vertex]] = vertex_to_stop_[vertex];
+	}
+	vertex_to_stop_ = move(vertex_to_stop);
 }
 
-graph::EdgeId TransportRouter::AddEdge(graph::VertexId from, graph::VertexId to, double time) {
+void TransportRouter::AddWaitEdge(graph::VertexId from, graph::VertexId to, StopId stop) {
+	const double time = (double)settings_.bus_wait_time;
+	AddEdge(from, to, time, { enEdgeItemType::WAIT, stop, 0, time });
+}
+
+graph::EdgeId TransportRouter::AddEdge(graph::VertexId from, graph::VertexId to, double time, EdgeItem item) {
 	graph::Edge<double> graph_edge = { from, to, time };
-	return graph_->AddEdge(graph_edge);
+	graph::EdgeId id = graph_->AddEdge(graph_edge);
+	// номера рёбер идут подряд, поэтому элемент ребра - следующий в массиве
+	edge_items_.push_back(item);
+	return id;
 }
 
-pair<graph::VertexId, graph::VertexId> TransportRouter::AddVertexId(const ::Stop* stop) {
+pair<graph::VertexId, graph::VertexId> TransportRouter::AddVertexId(StopId stop) {
 	pair<graph::VertexId, graph::VertexId> pair;
 	pair.first = last_vertex_id_;
 	pair.second = ++last_vertex_id_;
+	if (stop >= stop_to_vertex_id_.size()) {
+		stop_to_vertex_id_.resize(stop + 1, { NO_VERTEX, NO_VERTEX });
+	}
 	stop_to_vertex_id_[stop] = pair;
+	vertex_to_stop_.resize(last_vertex_id_ + 1);
+	vertex_to_stop_[pair.first] = stop;
+	vertex_to_stop_[pair.second] = stop;
 	++last_vertex_id_;
-	return stop_to_vertex_id_.at(stop);
+	return pair;
+}
+
+pair<graph::VertexId, graph::VertexId> TransportRouter::GetVertexId(StopId stop) {
+	return GetStopVertexId(stop);
 }
 
-pair<graph::VertexId, graph::VertexId> TransportRouter::GetVertexId(const ::Stop* stop) {
-	return stop_to_vertex_id_.at(stop);
+optional<OptimalRoute> TransportRouter::GetOptimalRoute(string_view from, string_view to) const {
+	RouteScratch scratch;
+	return GetOptimalRoute(from, to, scratch);
 }
 
-optional<OptimalRoute> TransportRouter::GetOptimalRoute(string_view from, string_view to) {
+optional<OptimalRoute> TransportRouter::GetOptimalRoute(string_view from, string_view to, RouteScratch& scratch) const {
 	using namespace graph;
 	using namespace transport_db;
 
-	auto [from_, _] = GetStopVertexId(db_.FindStop(from));
-	auto [to_, __] = GetStopVertexId(db_.FindStop(to));
-	vector<Router<double>::RouteInfo> routes;
+	const ::Stop* from_stop = db_.FindStop(from);
+	const ::Stop* to_stop = db_.FindStop(to);
+	if (from_stop == nullptr || to_stop == nullptr) {
+		return nullopt;
+	}
+	const transport_db::detail::StopsPair key{ from_stop->id, to_stop->id };
+	// отключённый кэш не блокируется, чтобы потоки запросов не ждали друг друга
+	const bool is_cached = settings_.route_cache_size > 0;
+	if (is_cached) {
+		lock_guard lock(route_cache_mutex_);
+		if (const auto* cached = route_cache_.Find(key)) {
+			++route_cache_hits_;
+			return *cached;
+		}
+		++route_cache_misses_;
+	}
+
+	auto [from_, _] = GetStopVertexId(key.first);
+	auto [to_, __] = GetStopVertexId(key.second);
 
-	auto route = router_->BuildRoute(from_, to_);
+	optional<OptimalRoute> result;
+	if (auto weight = BuildRoute(from_, to_, scratch)) {
+		result = RouterResultParser(*weight, scratch.edges);
+	}
+
+	if (is_cached) {
+		lock_guard lock(route_cache_mutex_);
+		route_cache_.Put(key, result);
+	}
+	return result;
+}
+
+vector<optional<OptimalRoute>> TransportRouter::GetOptimalRoutes(string_view from, const vector<string_view>& to,
+																 RouteScratch& scratch) const {
+	vector<optional<OptimalRoute>> result;
+	result.reserve(to.size());
+	// таблицы путей и сжатие иерархий и так отвечают на каждый запрос быстро
+	const bool is_search = settings_.router_type == enRouterType::DIJKSTRA
+		|| settings_.router_type == enRouterType::ASTAR
+		|| settings_.router_type == enRouterType::BIDIRECTIONAL;
+	if (!is_search || to.size() < 2) {
+		for (const auto& to_stop : to) {
+			result.push_back(GetOptimalRoute(from, to_stop, scratch));
+		}
+		return result;
+	}
 
-	if (!route) {
+	const ::Stop* from_stop = db_.FindStop(from);
+	if (from_stop == nullptr) {
+		return vector<optional<OptimalRoute>>(to.size());
+	}
+	// номера ответов, которых нет в кэше, и их ключи
+	vector<pair<size_t, transport_db::detail::StopsPair>> missed;
+	const bool is_cached = settings_.route_cache_size > 0;
+	{
+		unique_lock lock(route_cache_mutex_, defer_lock);
+		if (is_cached) {
+			lock.lock();
+		}
+		for (const auto& to_name : to) {
+			const ::Stop* to_stop = db_.FindStop(to_name);
+			if (to_stop == nullptr) {
+				result.push_back(nullopt);
+				continue;
+			}
+			const transport_db::detail::StopsPair key{ from_stop->id, to_stop->id };
+			if (is_cached) {
+				if (const auto* cached = route_cache_.Find(key)) {
+					++route_cache_hits_;
+					result.push_back(*cached);
+					continue;
+				}
+				++route_cache_misses_;
+			}
+			missed.push_back({ result.size(), key });
+			result.push_back(nullopt);
+		}
+	}
+	if (missed.empty()) {
+		return result;
+	}
+
+	auto [from_, _] = GetStopVertexId(from_stop->id);
+	vector<graph::VertexId> targets;
+	for (const auto& [i, key] : missed) {
+		targets.push_back(GetStopVertexId(key.second).first);
+	}
+	// A* и двунаправленный поиск отвечают на группу тем же деревом Дейкстры: время в пути
+	// то же, а из равных по времени маршрутов выбирается маршрут дерева, как при DIJKSTRA,
+	// и он может отличаться от ответа на одиночный запрос. Это намеренно: ответы на группу
+	// не зависят от способа поиска
+	dijkstra_router_->BuildRoutesTree(from_, targets, scratch.forward);
+	for (size_t k = 0; k < missed.size(); ++k) {
+		if (auto weight = dijkstra_router_->BuildRoute(scratch.forward, targets[k], scratch.edges)) {
+			result[missed[k].first] = RouterResultParser(*weight, scratch.edges);
+		}
+	}
+
+	if (is_cached) {
+		lock_guard lock(route_cache_mutex_);
+		for (const auto& [i, key] : missed) {
+			route_cache_.Put(key, result[i]);
+		}
+	}
+	return result;
+}
+
+// Поездки считаются по рёбрам ожидания: каждая посадка в автобус начинается с ожидания
+// в обеих моделях графа
+optional<vector<ParetoOption>> TransportRouter::GetParetoRoutes(string_view from, string_view to) const {
+	const ::Stop* from_stop = db_.FindStop(from);
+	const ::Stop* to_stop = db_.FindStop(to);
+	if (from_stop == nullptr || to_stop == nullptr) {
+		return nullopt;
+	}
+	auto routes = dijkstra_router_->BuildParetoRoutes(GetStopVertexId(from_stop->id).first, GetStopVertexId(to_stop->id).first,
+		[this](graph::EdgeId edge_id) -> size_t {
+			return edge_items_[edge_id].type == enEdgeItemType::WAIT ? 1 : 0;
+		});
+	if (routes.empty()) {
 		return nullopt;
 	}
 
-	return RouterResultParser(move(route.value()));
+	vector<ParetoOption> result;
+	result.reserve(routes.size());
+	for (auto it = routes.rbegin(); it != routes.rend(); ++it) {
+		const int rides = static_cast<int>(it->count);
+		result.push_back({ max(rides - 1, 0), RouterResultParser(it->route.weight, it->route.edges) });
+	}
+	return result;
 }
 
-OptimalRoute TransportRouter::RouterResultParser(graph::Router<double>::RouteInfo route) {
+optional<RouteTimes> TransportRouter::GetRouteTimes(const vector<string_view>& from, const vector<string_view>& to) const {
+	auto get_vertexes = [this](const vector<string_view>& stops) -> optional<vector<graph::VertexId>> {
+		vector<graph::VertexId> vertexes;
+		vertexes.reserve(stops.size());
+		for (const auto& stop_name : stops) {
+			const ::Stop* stop = db_.FindStop(stop_name);
+			if (stop == nullptr) {
+				return nullopt;
+			}
+			vertexes.push_back(GetStopVertexId(stop->id).first);
+		}
+		return vertexes;
+	};
+	const auto from_vertexes = get_vertexes(from);
+	const auto to_vertexes = get_vertexes(to);
+	if (!from_vertexes || !to_vertexes) {
+		return nullopt;
+	}
+
+	RouteTimes times(from_vertexes->size(), vector<optional<double>>(to_vertexes->size()));
+	graph::SearchSpace<double> tree;
+	for (size_t i = 0; i < from_vertexes->size(); ++i) {
+		const graph::VertexId from_ = (*from_vertexes)[i];
+		if (router_ || hub_router_) {
+			for (size_t j = 0; j < to_vertexes->size(); ++j) {
+				const graph::VertexId to_ = (*to_vertexes)[j];
+				times[i][j] = router_ ? router_->GetRouteWeight(from_, to_) : hub_router_->GetRouteWeight(from_, to_);
+			}
+			continue;
+		}
+		// поиск останавливается, как только пройдены все остановки назначения
+		dijkstra_router_->BuildRoutesTree(from_, *to_vertexes, tree);
+		for (size_t j = 0; j < to_vertexes->size(); ++j) {
+			if (const graph::VertexId to_ = (*to_vertexes)[j]; tree.IsReached(to_)) {
+				times[i][j] = tree.weights[to_];
+			}
+		}
+	}
+	return times;
+}
+
+optional<vector<ReachableStop>> TransportRouter::GetReachableStops(string_view from, double max_time) const {
+	const ::Stop* from_stop = db_.FindStop(from);
+	if (from_stop == nullptr) {
+		return nullopt;
+	}
+	// время прибытия на остановку - вес пути до её вершины прибытия, как и в запросе Route
+	vector<ReachableStop> result;
+	for (const auto& [vertex, time] : dijkstra_router_->GetReachableVertices(GetStopVertexId(from_stop->id).first, max_time)) {
+		const StopId stop = vertex_to_stop_[vertex];
+		if (GetStopVertexId(stop).first == vertex) {
+			result.push_back({ &db_.GetStop(stop), time });
+		}
+	}
+	return result;
+}
+
+RouteCacheStats TransportRouter::GetRouteCacheStats() const {
+	return { route_cache_hits_, route_cache_misses_ };
+}
+
+// Все способы поиска пишут рёбра пути сразу в буфер, поиски по запросу работают
+// в рабочих массивах потока
+optional<double> TransportRouter::BuildRoute(graph::VertexId from, graph::VertexId to, RouteScratch& scratch) const {
+	auto& edges = scratch.edges;
+	switch (settings_.router_type) {
+	case enRouterType::DIJKSTRA:
+		return dijkstra_router_->BuildRoute(from, to, scratch.forward, edges);
+	case enRouterType::BIDIRECTIONAL:
+		return dijkstra_router_->BuildRouteBidirectional(from, to, scratch.forward, scratch.backward, edges);
+	case enRouterType::CONTRACTION_HIERARCHIES:
+		return ch_router_->BuildRoute(from, to, scratch.forward, scratch.backward, edges);
+	case enRouterType::LAZY_ROWS:
+		return lazy_router_->BuildRoute(from, to, edges);
+	case enRouterType::HUB_LABELS:
+		return hub_router_->BuildRoute(from, to, edges);
+	case enRouterType::ASTAR: {
+		const auto& all_stops = db_.GetStops();
+		const geo::Coordinates target = all_stops[vertex_to_stop_.at(to)].coord;
+		auto heuristic = [this, &all_stops, target](graph::VertexId vertex) {
+			return geo::ComputeDistance(all_stops[vertex_to_stop_[vertex]].coord, target) * heuristic_scale_;
+		};
+		return dijkstra_router_->BuildRoute(from, to, heuristic, scratch.forward, edges);
+	}
+	case enRouterType::ALL_PAIRS:
+		break;
+	}
+	return router_->BuildRoute(from, to, edges);
+}
+
+OptimalRoute TransportRouter::RouterResultParser(double weight, const vector<graph::EdgeId>& edges) const {
 	OptimalRoute optimal_route;
-	if (route.edges.empty()) {
+	if (edges.empty()) {
 		return optimal_route;
 	}
 
 	// основной маршрут
-	for (const auto& edge_id : route.edges) {
-		optimal_route.items.push_back(edge_id_to_item_.at(edge_id));
+	const auto& all_stops = db_.GetStops();
+	const auto& all_buses = db_.GetBuses();
+	for (const auto& edge_id : edges) {
+		const EdgeItem& item = edge_items_.at(edge_id);
+		switch (item.type) {
+		case enEdgeItemType::NONE:
+			// посадка и высадка в модели маршрутов
+			break;
+		case enEdgeItemType::WAIT:
+			optimal_route.items.push_back(WaitItem{ &all_stops[item.index], static_cast<int>(item.time) });
+			break;
+		case enEdgeItemType::BUS: {
+			// перегоны одной поездки идут подряд, между разными поездками всегда есть ожидание
+			auto* last_bus = optimal_route.items.empty() ? nullptr : get_if<BusItem>(&optimal_route.items.back());
+			if (last_bus) {
+				last_bus->span_count += static_cast<int>(item.span_count);
+				last_bus->time += item.time;
+			}
+			else {
+				optimal_route.items.push_back(BusItem{ &all_buses[item.index], static_cast<int>(item.span_count), item.time });
+			}
+			break;
+		}
+		}
 	}
-	optimal_route.total_time = route.weight;
+	optimal_route.total_time = weight;
 
 	return optimal_route;
 }
 
-pair<graph::VertexId, graph::VertexId> TransportRouter::GetStopVertexId(const ::Stop* stop) {
-	return stop_to_vertex_id_.at(stop);
+pair<graph::VertexId, graph::VertexId> TransportRouter::GetStopVertexId(StopId stop) const {
+	if (stop >= stop_to_vertex_id_.size() || stop_to_vertex_id_[stop].first == NO_VERTEX) {
+		throw out_of_range("Stop "s + db_.GetStop(stop).name + " is not routed"s);
+	}
+	return stop_to_vertex_id_[stop];
+}
+
+size_t TransportRouter::GetBuildThreadCount() const {
+	if (settings_.build_threads > 0) {
+		return settings_.build_threads;
+	}
+	return max(thread::hardware_concurrency(), 1u);
+}
+
+size_t TransportRouter::GetQueryThreadCount() const {
+	if (settings_.query_threads > 0) {
+		return settings_.query_threads;
+	}
+	return max(thread::hardware_concurrency(), 1u);
+}
+
+// Время поездки между соседними остановками не меньше расстояния между ними по прямой,
+// делённого на наибольшую скорость по прямой среди всех перегонов. По неравенству треугольника
+// эта оценка допустима для любого пути, даже если дорожные расстояния меньше расстояний по прямой.
+// Некольцевой автобус едет и обратно, а расстояние в обратную сторону может быть другим
+double TransportRouter::ComputeHeuristicScale() const {
+	double max_speed = 0.;
+	// false - перегон с нулевым временем, тогда допустимой оценки нет
+	auto add_span = [this, &max_speed](StopId from, StopId to) {
+		const double geo_distance = geo::ComputeDistance(db_.GetStop(from).coord, db_.GetStop(to).coord);
+		if (IsZero(geo_distance)) {
+			return true;
+		}
+		const double time = db_.GetStopsDistance(from, to) / KmphToMpm(settings_.bus_velocity);
+		if (IsZero(time)) {
+			return false;
+		}
+		max_speed = max(max_speed, geo_distance / time);
+		return true;
+	};
+	for (const auto& bus : db_.GetBuses()) {
+		for (auto it = next(bus.route.begin()); it < bus.route.end(); ++it) {
+			if (!add_span(*prev(it), *it) || (!bus.is_roundtrip && !add_span(*it, *prev(it)))) {
+				return 0.;
+			}
+		}
+	}
+	if (IsZero(max_speed)) {
+		return 0.;
+	}
+	// запас на погрешность вычисления расстояний
+	return (1. - EPSILON) / max_speed;
 }
 
 // конвертер в минуты
-inline double TransportRouter::KmphToMpm(double kmph) {
+inline double TransportRouter::KmphToMpm(double kmph) const {
 	return kmph * 1000 / 60;
 }
 
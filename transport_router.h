@@ -3,8 +3,16 @@
 #include "domain.h"
 #include "graph.h"
 #include "router.h"
+#include "search_space.h"
+#include "dijkstra_router.h"
+#include "contraction_hierarchy.h"
+#include "lazy_router.h"
+#include "hub_labels.h"
 #include "transport_catalogue.h"
+#include "lru_cache.h"
 
+#include <atomic>
+#include <cstdint>
 #include <utility>
 #include <vector>
 #include <set>
@@ -13,23 +21,62 @@
 #include <memory>
 #include <optional>
 #include <functional>
+#include <limits>
+#include <mutex>
 
 namespace ptb { class Protobuffer; }
 
 namespace router {
 
+// способ поиска маршрута
+enum class enRouterType {
+    ALL_PAIRS = 0,  // таблица всех кратчайших путей, строится при создании базы
+    DIJKSTRA,       // алгоритм Дейкстры по запросу
+    CONTRACTION_HIERARCHIES,  // сжатие иерархий, шорткаты строятся при создании базы
+    ASTAR,          // A* по запросу с оценкой по расстоянию между остановками
+    BIDIRECTIONAL,  // двунаправленный алгоритм Дейкстры по запросу
+    LAZY_ROWS,      // строки таблицы маршрутов строятся при первом запросе из остановки
+    HUB_LABELS,     // метки 2-hop покрытия, строятся при создании базы
+};
+
+// граф для поиска маршрутов
+enum class enGraphModel {
+    STOP_PAIRS = 0,  // ребро из каждой остановки маршрута в каждую следующую, O(L^2) рёбер
+    LINES,           // вершина на каждую остановку каждого маршрута, O(L) рёбер
+};
+
+// нумерация вершин графа
+enum class enVertexOrder {
+    INSERTION = 0,  // в порядке добавления остановок
+    HILBERT,        // вдоль кривой Гильберта по координатам остановок
+    RCM,            // обратный алгоритм Катхилла - Макки по связям графа
+};
+
 struct RoutingSettings {
     int bus_wait_time = 0;
     double bus_velocity = 0.0;
+    enRouterType router_type = enRouterType::ALL_PAIRS;
+    // число потоков для построения таблицы маршрутов, 0 - по числу ядер
+    int build_threads = 0;
+    // число маршрутов в кэше ответов, 0 - кэш отключён
+    int route_cache_size = 0;
+    // число хранимых строк таблицы маршрутов для LAZY_ROWS
+    int route_rows_limit = 1000;
+    // число потоков для ответов на запросы Route, 0 - по числу ядер
+    int query_threads = 1;
+    enGraphModel graph_model = enGraphModel::STOP_PAIRS;
+    enVertexOrder vertex_order = enVertexOrder::INSERTION;
 };
 
+// Элементы маршрута ссылаются на остановки и автобусы справочника,
+// имена подставляются только при выводе ответа
 struct WaitItem {
-    std::string stop_name;
+    const ::Stop* stop = nullptr;
     int time = 0;
 };
 
 struct BusItem {
-    std::string bus_name;
+    const ::Bus* bus = nullptr;
     int span_count = 0;
     double time = 0.0;
 };
@@ -41,6 +88,53 @@ struct OptimalRoute {
     std::vector<RouteItem> items;
 };
 
+// вид элемента маршрута на ребре графа
+enum class enEdgeItemType : uint8_t {
+    NONE = 0,  // посадка и высадка в модели маршрутов
+    WAIT,
+    BUS,
+};
+
+// Элемент маршрута на ребре графа: номер остановки (WAIT) или автобуса (BUS)
+// в справочнике вместо копии имени
+struct EdgeItem {
+    enEdgeItemType type = enEdgeItemType::NONE;
+    uint32_t index = 0;
+    uint32_t span_count = 0;
+    double time = 0.0;
+};
+
+// Рабочая память запроса маршрута. У каждого потока своя, между запросами
+// переиспользуется без новых выделений: поиски по запросу пишут в неё веса, рёбра и очереди,
+// а сбрасываются только затронутые вершины
+struct RouteScratch {
+    std::vector<graph::EdgeId> edges;
+    // прямой поиск, дерево путей и A*; обратный - для двунаправленных поисков
+    graph::SearchSpace<double> forward;
+    graph::SearchSpace<double> backward;
+};
+
+// самый быстрый маршрут с заданным числом пересадок
+struct ParetoOption {
+    int transfers = 0;
+    OptimalRoute route;
+};
+
+// остановка, достижимая за заданное время, и время прибытия на неё
+struct ReachableStop {
+    const ::Stop* stop = nullptr;
+    double time = 0.0;
+};
+
+// время в пути для каждой пары остановок, строка на каждую остановку отправления;
+// пустая ячейка - маршрута нет
+using RouteTimes = std::vector<std::vector<std::optional<double>>>;
+
+struct RouteCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+};
+
 class TransportRouter {
 private:
     friend ptb::Protobuffer;
@@ -50,20 +144,60 @@ public:
                     RoutingSettings settings);
     void InitGraph();
     void InitRouter();
-    std::optional<OptimalRoute> GetOptimalRoute(std::string_view from, std::string_view to);
+    void InitRouterEngine();
+    // поиск Дейкстры по графу нужен при любом способе поиска маршрута, например для изохрон
+    void InitSearchRouter();
+    void InitRouteCache();
+    // Запросы маршрутов только читают маршрутизатор и могут выполняться из нескольких потоков
+    // одновременно, если у каждого потока свой RouteScratch
+    std::optional<OptimalRoute> GetOptimalRoute(std::string_view from, std::string_view to) const;
+    std::optional<OptimalRoute> GetOptimalRoute(std::string_view from, std::string_view to,
+                                                RouteScratch& scratch) const;
+    // Маршруты из одной остановки в несколько: для поиска по запросу строится одно дерево путей.
+    // Из равных по времени маршрутов выбирается маршрут дерева Дейкстры и для A*, и для двунаправленного поиска
+    std::vector<std::optional<OptimalRoute>> GetOptimalRoutes(std::string_view from,
+                                                              const std::vector<std::string_view>& to,
+                                                              RouteScratch& scratch) const;
+    // Для каждого числа пересадок - самый быстрый маршрут, если он быстрее всех маршрутов с меньшим
+    // числом пересадок, по возрастанию числа пересадок. nullopt - нет остановки или маршрута
+    std::optional<std::vector<ParetoOption>> GetParetoRoutes(std::string_view from, std::string_view to) const;
+    // Время в пути из каждой остановки from в каждую остановку to: таблицы путей отвечают
+    // на каждую пару сразу, иначе строится одно дерево путей на остановку отправления.
+    // nullopt - нет какой-то из остановок
+    std::optional<RouteTimes> GetRouteTimes(const std::vector<std::string_view>& from,
+                                            const std::vector<std::string_view>& to) const;
+    // Остановки, до которых можно доехать из from не дольше чем за max_time минут, в порядке времени
+    // прибытия. Ограниченный поиск Дейкстры не выходит за max_time; nullopt - нет такой остановки
+    std::optional<std::vector<ReachableStop>> GetReachableStops(std::string_view from, double max_time) const;
+    // Попадания и промахи кэша маршрутов с последнего сброса кэша; при отключённом кэше - нули
+    RouteCacheStats GetRouteCacheStats() const;
+    size_t GetQueryThreadCount() const;
     void AddVertexesToGraph();
     void AddEdgesToGraph();
+    void RenumberVertices();
+
+    // Добавляют в готовый маршрутизатор остановку или автобус, уже внесённые в справочник,
+    // и обновляют только затронутую часть поисковых данных. Не совмещаются с запросами маршрутов
+    void AddStop(StopId stop);
+    void AddBus(BusId bus);
 
 private:
-    std::pair<graph::VertexId, graph::VertexId> GetStopVertexId(const ::Stop* stop);
-    OptimalRoute RouterResultParser(graph::Router<double>::RouteInfo route);
-    inline double KmphToMpm(double kmph);
-    graph::EdgeId AddEdge(graph::VertexId from, graph::VertexId to, double distance);
-    void AddWaitEdge(graph::VertexId from, graph::VertexId to, const Stop* stop);
-    std::pair<graph::VertexId, graph::VertexId> AddVertexId(const ::Stop* stop);
-    std::pair<graph::VertexId, graph::VertexId> GetVertexId(const ::Stop* stop);
+    std::pair<graph::VertexId, graph::VertexId> GetStopVertexId(StopId stop) const;
+    std::optional<double> BuildRoute(graph::VertexId from, graph::VertexId to, RouteScratch& scratch) const;
+    OptimalRoute RouterResultParser(double weight, const std::vector<graph::EdgeId>& edges) const;
+    inline double KmphToMpm(double kmph) const;
+    size_t GetBuildThreadCount() const;
+    void UpdateRouterEngine(graph::EdgeId first_edge);
+    double ComputeHeuristicScale() const;
+    graph::EdgeId AddEdge(graph::VertexId from, graph::VertexId to, double time, EdgeItem item);
+    void AddWaitEdge(graph::VertexId from, graph::VertexId to, StopId stop);
+    std::pair<graph::VertexId, graph::VertexId> AddVertexId(StopId stop);
+    std::pair<graph::VertexId, graph::VertexId> GetVertexId(StopId stop);
     template<typename It>
-    void AddEdgesFromBus(It from, It to, const Bus* bus);
+    void AddEdgesFromBus(It from, It to, BusId bus);
+    template<typename It>
+    void AddLineFromBus(It from, It to, BusId bus);
+    void AddBusToGraph(const ::Bus& bus);
 
     graph::VertexId last_vertex_id_ = 0;
     const transport_db::TransportCatalogue& db_;
@@ -71,17 +205,35 @@ private:
     RoutingSettings settings_;
     std::unique_ptr<graph::DirectedWeightedGraph<double>> graph_;
     std::unique_ptr<graph::Router<double>> router_;
+    std::unique_ptr<graph::DijkstraRouter<double>> dijkstra_router_;
+    std::unique_ptr<graph::ContractionHierarchyRouter<double>> ch_router_;
+    std::unique_ptr<graph::LazyRouter<double>> lazy_router_;
+    std::unique_ptr<graph::HubLabelRouter<double>> hub_router_;
+
+    // вершины прибытия и отправления по номеру остановки; NO_VERTEX - остановки нет в графе
+    static constexpr graph::VertexId NO_VERTEX = std::numeric_limits<graph::VertexId>::max();
+    std::vector<std::pair<graph::VertexId, graph::VertexId>> stop_to_vertex_id_;
+    std::vector<StopId> vertex_to_stop_;
+    // номер вершины после перенумерации по номеру в порядке добавления
+    std::vector<graph::VertexId> vertex_permutation_;
+    // минут на метр расстояния по прямой, оценка снизу для A*
+    double heuristic_scale_ = 0.0;
+    // элементы маршрута по номеру ребра
+    std::vector<EdgeItem> edge_items_;
 
-    std::unordered_map<
-        const ::Stop*,
-        std::pair<graph::VertexId, graph::VertexId>> stop_to_vertex_id_;
-    std::unordered_map<
-        graph::EdgeId,
-        RouteItem> edge_id_to_item_;
+    // готовые ответы по паре остановок, включая отсутствие маршрута
+    mutable std::mutex route_cache_mutex_;
+    mutable cache::LruCache<
+        transport_db::detail::StopsPair,
+        std::optional<OptimalRoute>,
+        transport_db::detail::StopsHasher> route_cache_;
+    // счётчики не требуют блокировки кэша
+    mutable std::atomic<size_t> route_cache_hits_{ 0 };
+    mutable std::atomic<size_t> route_cache_misses_{ 0 };
 };
 
 template<typename It>
-void TransportRouter::AddEdgesFromBus(It from, It to, const Bus* bus) {
+void TransportRouter::AddEdgesFromBus(It from, It to, BusId bus) {
     using namespace graph;
     for (auto from_ = from; from_ != std::prev(to); ++from_) {
         double accumulated_weight = 0.;
@@ -89,11 +241,32 @@ void TransportRouter::AddEdgesFromBus(It from, It to, const Bus* bus) {
 
         for (auto to_ = std::next(from_); to_ != to; ++to_) {
             spans_count += 1;
-            accumulated_weight += db_.GetStopsDistance({ *std::prev(to_), *to_ }) / KmphToMpm(settings_.bus_velocity);
+            accumulated_weight += db_.GetStopsDistance(*std::prev(to_), *to_) / KmphToMpm(settings_.bus_velocity);
             auto [_, v_from] = GetVertexId(*from_);
             auto [v_to, __] = GetVertexId(*to_);
-            EdgeId id = AddEdge(v_from, v_to, accumulated_weight);
-            edge_id_to_item_[id] = BusItem{ bus->name, spans_count, accumulated_weight };
+            AddEdge(v_from, v_to, accumulated_weight,
+                    { enEdgeItemType::BUS, bus, static_cast<uint32_t>(spans_count), accumulated_weight });
+        }
+    }
+}
+
+// Вершины автобуса на каждой остановке маршрута соединены перегонами, посадка ведёт
+// из вершины после ожидания, высадка - в вершину прибытия на остановку. Перегоны
+// одной поездки собираются в один BusItem при разборе найденного пути
+template<typename It>
+void TransportRouter::AddLineFromBus(It from, It to, BusId bus) {
+    using namespace graph;
+    for (auto it = from; it != to; ++it) {
+        const VertexId vertex = last_vertex_id_++;
+        vertex_to_stop_.push_back(*it);
+        auto [arrival, departure] = GetVertexId(*it);
+        if (it != from) {
+            const double time = db_.GetStopsDistance(*std::prev(it), *it) / KmphToMpm(settings_.bus_velocity);
+            AddEdge(vertex - 1, vertex, time, { enEdgeItemType::BUS, bus, 1, time });
+            AddEdge(vertex, arrival, 0., {});
+        }
+        if (std::next(it) != to) {
+            AddEdge(departure, vertex, 0., {});
         }
     }
 }